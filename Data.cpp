@@ -0,0 +1,32 @@
+#include <boost/make_shared.hpp>
+
+#include "Data.h"
+
+namespace pipeline {
+
+// version 0 is reserved for absent data
+boost::atomic<boost::uint64_t> Data::_nextVersion(1);
+
+boost::uint64_t
+Data::getContentKey() const {
+
+	boost::shared_ptr<const ContentKey> contentKey = boost::atomic_load(&_contentKey);
+
+	if (!contentKey || contentKey->version != _version)
+		return 0;
+
+	return contentKey->key;
+}
+
+void
+Data::setContentKey(boost::uint64_t key) {
+
+	boost::shared_ptr<ContentKey> contentKey = boost::make_shared<ContentKey>();
+
+	contentKey->key     = key;
+	contentKey->version = _version;
+
+	boost::atomic_store(&_contentKey, boost::shared_ptr<const ContentKey>(contentKey));
+}
+
+} // namespace pipeline
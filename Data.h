@@ -1,6 +1,11 @@
 #ifndef DATA_H__
 #define DATA_H__
 
+#include <cstddef>
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/shared_mutex.hpp>
 
 namespace pipeline {
@@ -10,22 +15,77 @@ class Data {
 public:
 
 	// default constructor
-	Data() {}
+	Data() : _version(nextVersion()) {}
 
 	// overwrite default copy constructor
-	Data(const Data&) {}
+	Data(const Data&) : _version(nextVersion()) {}
 
 	// overwrite default assignment operator
-	Data& operator=(const Data&) { return *this; }
+	Data& operator=(const Data&) { touch(); return *this; }
 
 	virtual ~Data() {}
 
 	boost::shared_mutex& getMutex() { return _mutex; }
 
+	/**
+	 * Get the memory used by this data object in bytes. Overwrite this method 
+	 * to let the MemoryManager release this data if the memory budget is 
+	 * exceeded. The default implementation returns 0, which means that the 
+	 * size is unknown.
+	 */
+	virtual std::size_t getSize() const { return 0; }
+
+	/**
+	 * Get the version of this data object. Versions are unique among all data 
+	 * objects and change whenever the content of a data object changes. 
+	 * Process nodes use them to find out whether their inputs changed since 
+	 * their last update.
+	 */
+	boost::uint64_t getVersion() const { return _version; }
+
+	/**
+	 * Assign a new version to this data object. SimpleProcessNode does this 
+	 * for all of its outputs after each update. If you change the content of 
+	 * a data object in place outside of an update, call this method yourself.
+	 */
+	void touch() { _version = nextVersion(); }
+
+	/**
+	 * Get the content key of this data object. In contrast to the version, 
+	 * the content key is the same for the same content in different program 
+	 * runs. It is used by the persistent output cache. Returns 0, if the 
+	 * content key is not known or the data changed since it was set.
+	 */
+	boost::uint64_t getContentKey() const;
+
+	/**
+	 * Set the content key for the current version of this data object.
+	 */
+	void setContentKey(boost::uint64_t key);
+
 private:
 
+	// a content key together with the version it is valid for
+	struct ContentKey {
+
+		boost::uint64_t key;
+		boost::uint64_t version;
+	};
+
+	static boost::uint64_t nextVersion() { return _nextVersion++; }
+
 	// a mutex to prevent concurrent access
 	boost::shared_mutex _mutex;
+
+	// the current version of this data object
+	boost::atomic<boost::uint64_t> _version;
+
+	// the content key and the version it is valid for, replaced as a whole 
+	// such that readers never see the key of one version with another
+	boost::shared_ptr<const ContentKey> _contentKey;
+
+	// the version to assign next
+	static boost::atomic<boost::uint64_t> _nextVersion;
 };
 
 } // namespace pipeline
@@ -0,0 +1,145 @@
+#include <algorithm>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "DataLocks.h"
+
+namespace pipeline {
+
+namespace {
+
+// the number of attempts to acquire all locks without blocking, before
+// lockWithBackoff() blocks
+const unsigned int MaxAttempts = 16;
+
+// the number of attempts that only yield, before lockWithBackoff() sleeps
+const unsigned int YieldAttempts = 4;
+
+// the longest pause between two attempts
+const unsigned int MaxPauseMicroseconds = 1000;
+
+} // anonymous namespace
+
+void
+DataLocks::add(boost::shared_ptr<Data> data, bool unique) {
+
+	if (!data)
+		return;
+
+	_entries.push_back(Entry(data, unique));
+}
+
+void
+DataLocks::prepare() {
+
+	std::sort(_entries.begin(), _entries.end());
+
+	unsigned int merged = 0;
+
+	for (unsigned int i = 0; i < _entries.size(); i++) {
+
+		if (merged > 0 && _entries[merged - 1].data == _entries[i].data) {
+
+			_entries[merged - 1].unique = _entries[merged - 1].unique || _entries[i].unique;
+			continue;
+		}
+
+		if (merged != i)
+			_entries[merged] = _entries[i];
+
+		merged++;
+	}
+
+	_entries.erase(_entries.begin() + merged, _entries.end());
+}
+
+void
+DataLocks::lock() {
+
+	prepare();
+
+	for (; _numLocked < _entries.size(); _numLocked++) {
+
+		Entry& entry = _entries[_numLocked];
+
+		if (entry.unique)
+			entry.data->getMutex().lock();
+		else
+			entry.data->getMutex().lock_shared();
+	}
+}
+
+bool
+DataLocks::tryLock() {
+
+	prepare();
+
+	for (; _numLocked < _entries.size(); _numLocked++) {
+
+		Entry& entry = _entries[_numLocked];
+
+		bool locked = (entry.unique ? entry.data->getMutex().try_lock() : entry.data->getMutex().try_lock_shared());
+
+		if (!locked) {
+
+			release(_numLocked);
+			_numLocked = 0;
+
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void
+DataLocks::lockWithBackoff() {
+
+	unsigned int pause = 1;
+
+	for (unsigned int attempt = 0; attempt < MaxAttempts; attempt++) {
+
+		if (tryLock())
+			return;
+
+		if (attempt < YieldAttempts) {
+
+			boost::this_thread::yield();
+			continue;
+		}
+
+		boost::this_thread::sleep(boost::posix_time::microseconds(pause));
+		pause = std::min(2*pause, MaxPauseMicroseconds);
+	}
+
+	// the sorted order guarantees progress
+	lock();
+}
+
+void
+DataLocks::unlock() {
+
+	release(_numLocked);
+
+	_numLocked = 0;
+	_entries.clear();
+}
+
+void
+DataLocks::release(unsigned int n) {
+
+	// in reverse order of acquisition
+	for (unsigned int i = n; i > 0; i--) {
+
+		Entry& entry = _entries[i - 1];
+
+		if (entry.unique)
+			entry.data->getMutex().unlock();
+		else
+			entry.data->getMutex().unlock_shared();
+	}
+}
+
+} // namespace pipeline
+
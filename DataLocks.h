@@ -0,0 +1,104 @@
+#ifndef PIPELINE_DATA_LOCKS_H__
+#define PIPELINE_DATA_LOCKS_H__
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Data.h"
+
+namespace pipeline {
+
+/**
+ * A set of read and write locks on data objects, which are acquired together.
+ * The locks are sorted by the address of the data and acquired in this
+ * order. Therefore, two DataLocks that share data objects can not deadlock,
+ * regardless of the order in which the data was added. Data added more than
+ * once is locked only once, with a write lock if any of the additions asked
+ * for one.
+ *
+ * The data objects are kept alive until the locks are released. A DataLocks
+ * object can be reused; it keeps its memory between uses.
+ */
+class DataLocks : public boost::noncopyable {
+
+public:
+
+	DataLocks() : _numLocked(0) {}
+
+	/**
+	 * Releases the locks, if they are held.
+	 */
+	~DataLocks() { unlock(); }
+
+	/**
+	 * Add a read lock on the given data.
+	 */
+	void addShared(boost::shared_ptr<Data> data) { add(data, false); }
+
+	/**
+	 * Add a write lock on the given data.
+	 */
+	void addUnique(boost::shared_ptr<Data> data) { add(data, true); }
+
+	/**
+	 * Acquire all added locks, blocking until they are available.
+	 */
+	void lock();
+
+	/**
+	 * Try to acquire all added locks without blocking. If one of them is not
+	 * available, no lock is held afterwards.
+	 *
+	 * @return True, if all locks have been acquired.
+	 */
+	bool tryLock();
+
+	/**
+	 * Acquire all added locks, without holding any of them while waiting.
+	 * Tries to acquire all locks at once and releases them again if one is
+	 * not available, with increasing pauses between the attempts. After a
+	 * number of failed attempts, lock() is used.
+	 */
+	void lockWithBackoff();
+
+	/**
+	 * Release the acquired locks and forget the added data.
+	 */
+	void unlock();
+
+private:
+
+	struct Entry {
+
+		Entry(boost::shared_ptr<Data> data_, bool unique_) :
+			data(data_),
+			unique(unique_) {}
+
+		bool operator<(const Entry& other) const { return data.get() < other.data.get(); }
+
+		boost::shared_ptr<Data> data;
+
+		// a write lock is requested
+		bool unique;
+	};
+
+	void add(boost::shared_ptr<Data> data, bool unique);
+
+	// sort the entries and merge duplicates
+	void prepare();
+
+	// release the first n entries
+	void release(unsigned int n);
+
+	std::vector<Entry> _entries;
+
+	// the number of entries currently locked
+	unsigned int _numLocked;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_DATA_LOCKS_H__
+
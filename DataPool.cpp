@@ -0,0 +1,20 @@
+#include <util/ProgramOptions.h>
+#include "DataPool.h"
+
+namespace pipeline {
+
+util::ProgramOption optionDataPoolSize(
+		util::_module           = "pipeline",
+		util::_long_name        = "dataPoolSize",
+		util::_description_text = "The maximal number of unused data objects to keep for reuse, per data type.",
+		util::_default_value    = 16);
+
+unsigned int
+DataPoolBase::getMaxFree() {
+
+	static int maxFree = optionDataPoolSize;
+
+	return (maxFree > 0 ? maxFree : 0);
+}
+
+} // namespace pipeline
@@ -0,0 +1,125 @@
+#ifndef PIPELINE_DATA_POOL_H__
+#define PIPELINE_DATA_POOL_H__
+
+#include <vector>
+
+#include <boost/pool/pool_alloc.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace pipeline {
+
+/**
+ * Non-template part of the data pools.
+ */
+class DataPoolBase {
+
+public:
+
+	/**
+	 * Get the maximal number of unused objects to keep per data type, as 
+	 * given by the program option 'dataPoolSize'.
+	 */
+	static unsigned int getMaxFree();
+};
+
+/**
+ * A process-wide pool of recycled objects of type T. Objects handed out by 
+ * acquire() are not destructed when their last shared pointer goes away, but 
+ * returned to the pool, such that they keep their allocated resources (e.g., 
+ * the pixel buffer of an image). The control blocks of the shared pointers 
+ * are allocated from a memory pool as well. Thus, in a steady state, 
+ * acquiring and releasing objects does not allocate heap memory.
+ *
+ * Objects are handed out as they were released. It is up to the user to 
+ * reinitialize them.
+ */
+template <typename T>
+class DataPool : public DataPoolBase {
+
+public:
+
+	/**
+	 * Get a recycled object, or a default constructed one if the pool is 
+	 * empty.
+	 */
+	static boost::shared_ptr<T> acquire() {
+
+		T* object = getInstance().take();
+
+		if (!object)
+			object = new T();
+
+		return boost::shared_ptr<T>(object, Recycler(), boost::fast_pool_allocator<T>());
+	}
+
+	/**
+	 * Get the number of unused objects currently held by the pool.
+	 */
+	static unsigned int numFree() {
+
+		DataPool& pool = getInstance();
+
+		boost::mutex::scoped_lock lock(pool._mutex);
+
+		return pool._free.size();
+	}
+
+private:
+
+	// returns objects to the pool instead of deleting them
+	struct Recycler {
+
+		void operator()(T* object) const {
+
+			getInstance().give(object);
+		}
+	};
+
+	static DataPool& getInstance() {
+
+		// Never destructed: Pooled objects might be released by static 
+		// objects that get destructed at program exit.
+		static DataPool* pool = new DataPool();
+
+		return *pool;
+	}
+
+	T* take() {
+
+		boost::mutex::scoped_lock lock(_mutex);
+
+		if (_free.empty())
+			return 0;
+
+		T* object = _free.back();
+		_free.pop_back();
+
+		return object;
+	}
+
+	void give(T* object) {
+
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+
+			if (_free.size() < getMaxFree()) {
+
+				_free.push_back(object);
+				return;
+			}
+		}
+
+		delete object;
+	}
+
+	boost::mutex _mutex;
+
+	// objects that can be handed out again
+	std::vector<T*> _free;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_DATA_POOL_H__
+
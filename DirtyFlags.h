@@ -0,0 +1,247 @@
+#ifndef PIPELINE_DIRTY_FLAGS_H__
+#define PIPELINE_DIRTY_FLAGS_H__
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace pipeline {
+
+/**
+ * A growable bitset with lock-free access to the individual flags. Setting,
+ * testing, and clearing single flags as well as counting the set flags can be
+ * done concurrently from several threads without locking.
+ *
+ * The flags are stored in segments of increasing size that never move in
+ * memory. Therefore, push_back() can be called while other threads access
+ * existing flags. Concurrent calls to push_back() and clear() are serialized
+ * internally.
+ */
+class DirtyFlags {
+
+	typedef boost::uint64_t word_type;
+
+	// number of bits per word
+	static const unsigned int WordBits = 64;
+
+	// number of words in the first segment, segment k has FirstSegment*2^k
+	static const unsigned int FirstSegment = 16;
+
+	// maximal number of segments
+	static const unsigned int MaxSegments = 32;
+
+public:
+
+	DirtyFlags() :
+		_size(0) {
+
+		for (unsigned int k = 0; k < MaxSegments; k++)
+			_segments[k] = 0;
+	}
+
+	~DirtyFlags() {
+
+		for (unsigned int k = 0; k < MaxSegments; k++)
+			delete[] _segments[k].load();
+	}
+
+	/**
+	 * Get the number of flags.
+	 */
+	unsigned int size() const {
+
+		return _size;
+	}
+
+	/**
+	 * Add a flag at the end.
+	 *
+	 * @param value The initial value of the new flag.
+	 */
+	void push_back(bool value) {
+
+		boost::mutex::scoped_lock lock(_resizeMutex);
+
+		unsigned int i = _size;
+
+		unsigned int k, offset;
+		locate(i/WordBits, k, offset);
+
+		if (!_segments[k]) {
+
+			unsigned int segmentSize = FirstSegment << k;
+
+			boost::atomic<word_type>* segment = new boost::atomic<word_type>[segmentSize];
+			for (unsigned int w = 0; w < segmentSize; w++)
+				segment[w] = 0;
+
+			_segments[k] = segment;
+		}
+
+		// not visible to set() and reset() before _size is increased
+		if (value)
+			word(i/WordBits).fetch_or(mask(i));
+		else
+			word(i/WordBits).fetch_and(~mask(i));
+
+		_size++;
+	}
+
+	/**
+	 * Remove all flags.
+	 */
+	void clear() {
+
+		boost::mutex::scoped_lock lock(_resizeMutex);
+
+		unsigned int numWords = (_size + WordBits - 1)/WordBits;
+
+		_size = 0;
+
+		for (unsigned int w = 0; w < numWords; w++)
+			word(w) = 0;
+	}
+
+	/**
+	 * Get the value of a flag. Flags beyond size() are not set.
+	 */
+	bool test(unsigned int i) const {
+
+		if (i >= _size)
+			return false;
+
+		return (word(i/WordBits).load() & mask(i)) != 0;
+	}
+
+	/**
+	 * Set a flag. Flags beyond size() are ignored.
+	 *
+	 * @return The previous value of the flag.
+	 */
+	bool set(unsigned int i) {
+
+		if (i >= _size)
+			return false;
+
+		return (word(i/WordBits).fetch_or(mask(i)) & mask(i)) != 0;
+	}
+
+	/**
+	 * Clear a flag. Flags beyond size() are ignored.
+	 *
+	 * @return The previous value of the flag.
+	 */
+	bool reset(unsigned int i) {
+
+		if (i >= _size)
+			return false;
+
+		return (word(i/WordBits).fetch_and(~mask(i)) & mask(i)) != 0;
+	}
+
+	/**
+	 * Set or clear all flags.
+	 */
+	void setAll(bool value) {
+
+		unsigned int size = _size;
+
+		for (unsigned int w = 0; w*WordBits < size; w++) {
+
+			word_type m = usedBits(w, size);
+
+			if (value)
+				word(w).fetch_or(m);
+			else
+				word(w).fetch_and(~m);
+		}
+	}
+
+	/**
+	 * Returns true, if at least one flag is set.
+	 */
+	bool any() const {
+
+		unsigned int size = _size;
+
+		for (unsigned int w = 0; w*WordBits < size; w++)
+			if (word(w).load() & usedBits(w, size))
+				return true;
+
+		return false;
+	}
+
+	/**
+	 * Get the number of set flags.
+	 */
+	unsigned int count() const {
+
+		unsigned int size = _size;
+		unsigned int num  = 0;
+
+		for (unsigned int w = 0; w*WordBits < size; w++)
+			num += popcount(word(w).load() & usedBits(w, size));
+
+		return num;
+	}
+
+private:
+
+	// non-copyable
+	DirtyFlags(const DirtyFlags&);
+	DirtyFlags& operator=(const DirtyFlags&);
+
+	static word_type mask(unsigned int i) {
+
+		return word_type(1) << (i%WordBits);
+	}
+
+	// the bits of word w that hold one of the first size flags
+	static word_type usedBits(unsigned int w, unsigned int size) {
+
+		unsigned int bits = size - w*WordBits;
+
+		return (bits >= WordBits ? ~word_type(0) : (word_type(1) << bits) - 1);
+	}
+
+	static void locate(unsigned int w, unsigned int& k, unsigned int& offset) {
+
+		// segment k starts at word FirstSegment*(2^k - 1)
+		unsigned int n = w/FirstSegment + 1;
+
+		k = 0;
+		while (n >>= 1)
+			k++;
+
+		offset = w - FirstSegment*((1u << k) - 1);
+	}
+
+	boost::atomic<word_type>& word(unsigned int w) const {
+
+		unsigned int k, offset;
+		locate(w, k, offset);
+
+		return _segments[k].load()[offset];
+	}
+
+	static unsigned int popcount(word_type x) {
+
+		x = x - ((x >> 1) & 0x5555555555555555ULL);
+		x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+		x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+
+		return (x*0x0101010101010101ULL) >> 56;
+	}
+
+	boost::atomic<boost::atomic<word_type>*> _segments[MaxSegments];
+
+	boost::atomic<unsigned int> _size;
+
+	// serializes push_back() and clear()
+	boost::mutex _resizeMutex;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_DIRTY_FLAGS_H__
+
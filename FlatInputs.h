@@ -0,0 +1,517 @@
+#ifndef PIPELINE_FLAT_INPUTS_H__
+#define PIPELINE_FLAT_INPUTS_H__
+
+#include <algorithm>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/type_traits.hpp>
+
+#include <signals/Callback.h>
+#include <util/foreach.h>
+#include "Inputs.h"
+#include "Logging.h"
+
+namespace pipeline {
+
+/**
+ * A multi-input that keeps the data pointers of all its inputs in one 
+ * contiguous array, such that process nodes with a large number of inputs can 
+ * iterate over them without an indirection per input. Signalling is not 
+ * shared: signals do not tell which output sent them, so a single receiver 
+ * could not dispatch them by index. As for Inputs<DataType>, each assigned 
+ * output gets its own connection, with its own sender, receiver, slots, and 
+ * callbacks. The connection only lacks the data pointer and the internal 
+ * signalling of a complete Input<DataType>. The dirty state of the inputs is 
+ * kept by the owning SimpleProcessNode, in one contiguous DirtyFlags per 
+ * multi-input.
+ *
+ * The inputs can be read while outputs publish new data and while inputs are 
+ * added. Therefore, operator[] and the iterators return the data pointers by 
+ * value. Adding inputs never moves the array under readers: if the array is 
+ * full, the inputs are copied into a larger one, which replaces the old one 
+ * atomically.
+ *
+ * FlatInputs can be used like Inputs:
+ * <code>
+ * FlatInputs<Image> _images;
+ *
+ * registerInputs(_images, "images");
+ *
+ * ...
+ *
+ * for (FlatInputs<Image>::const_iterator i = _images.begin(); i != _images.end(); i++)
+ *   sum += (*i)->value;
+ * </code>
+ *
+ * Only Data types are supported, i.e., DataType has to be derived from Data.
+ */
+template <typename DataType>
+class FlatInputs : public MultiInput {
+
+	BOOST_STATIC_ASSERT((boost::is_base_of<Data, DataType>::value));
+
+	/**
+	 * The data pointers of all inputs. Only the first 'size' elements are in 
+	 * use, the remaining ones are reserved for inputs to be added.
+	 */
+	struct Storage {
+
+		Storage(unsigned int capacity) :
+			data(capacity),
+			size(0) {}
+
+		std::vector<boost::shared_ptr<DataType> > data;
+
+		boost::atomic<unsigned int> size;
+	};
+
+	/**
+	 * The connection to one assigned output. It provides the receiver for
+	 * signals of the output and the sender for backwards signals to the
+	 * output, and is registered with its own slots and callbacks. The data 
+	 * itself is stored in the owning FlatInputs.
+	 */
+	class Connection : public InputBase {
+
+		typedef signals::Callback<OutputPointerSet, signals::WeakTracking<signals::CallbackBase> > InternalCallbackType;
+
+	public:
+
+		Connection(FlatInputs& owner, unsigned int index) :
+			_owner(owner),
+			_index(index),
+			_getTypedData(0) {}
+
+		/**
+		 * Connect to an output. The type of the data will be checked whenever
+		 * the output sets a new data pointer.
+		 */
+		void connect(OutputBase& output) {
+
+			connect(output, 0);
+		}
+
+		/**
+		 * Connect to an output of a type that is known at compile time.
+		 */
+		template <typename OutputDataType>
+		void connectTyped(OutputImpl<OutputDataType>& output) {
+
+			BOOST_STATIC_ASSERT((boost::is_convertible<OutputDataType*, DataType*>::value));
+
+			connect(output, &getTypedData<OutputDataType>);
+		}
+
+		boost::shared_ptr<Data> getSharedDataPointer() const {
+
+			return _owner.getSharedDataPointer(_index);
+		}
+
+		// connections are created and destructed by the owning FlatInputs
+		bool accept(OutputBase&) { return false; }
+		bool accept(boost::shared_ptr<Data>) { return false; }
+		void unset() {}
+
+		operator bool() const { return static_cast<bool>(getSharedDataPointer()); }
+
+		bool isSet() { return static_cast<bool>(getSharedDataPointer()); }
+
+	private:
+
+		typedef boost::shared_ptr<DataType> (*typed_data_getter)(OutputBase&);
+
+		template <typename OutputDataType>
+		static boost::shared_ptr<DataType> getTypedData(OutputBase& output) {
+
+			return static_cast<OutputImpl<OutputDataType>&>(output).getPublishedPointer();
+		}
+
+		void connect(OutputBase& output, typed_data_getter getTypedData) {
+
+			_getTypedData = getTypedData;
+
+			_outputPointerSetCallback.reset(new InternalCallbackType(boost::bind(&Connection::onOutputPointerSet, this, _1)));
+			_outputPointerSetCallback->track(_outputPointerSetCallback);
+
+			getReceiver().registerCallback(*_outputPointerSetCallback);
+
+			output.getSender().connect(getReceiver());
+			getSender().connect(output.getReceiver());
+
+			setAssignedOutput(output);
+
+			setData(output);
+		}
+
+		void onOutputPointerSet(const OutputPointerSet&) {
+
+			setData(getAssignedOutput());
+		}
+
+		void setData(OutputBase& output) {
+
+			if (_getTypedData)
+				_owner.setData(_index, _getTypedData(output));
+			else
+				_owner.setData(_index, output.getSharedDataPointer());
+		}
+
+		FlatInputs& _owner;
+
+		// the number of this connection in the owning FlatInputs
+		unsigned int _index;
+
+		// set by connectTyped(), gets the data without a runtime type check
+		typed_data_getter _getTypedData;
+
+		boost::shared_ptr<InternalCallbackType> _outputPointerSetCallback;
+	};
+
+public:
+
+	/**
+	 * Iterates over the data pointers of the inputs, returned by value. The 
+	 * iterator keeps the storage it was created on, such that the storage is 
+	 * loaded only once per iteration. Inputs added after the iterator was 
+	 * created are not visited. end() is a sentinel that compares equal to 
+	 * every iterator that passed the last input of its storage.
+	 */
+	class const_iterator : public boost::iterator_facade<
+			const_iterator,
+			boost::shared_ptr<DataType>,
+			boost::forward_traversal_tag,
+			boost::shared_ptr<DataType> > {
+
+	public:
+
+		const_iterator() :
+			_size(0),
+			_index(0) {}
+
+		const_iterator(boost::shared_ptr<Storage> storage, unsigned int index) :
+			_storage(storage),
+			_size(storage->size.load(boost::memory_order_acquire)),
+			_index(index) {}
+
+	private:
+
+		friend class boost::iterator_core_access;
+
+		boost::shared_ptr<DataType> dereference() const {
+
+			return boost::atomic_load(&_storage->data[_index]);
+		}
+
+		bool equal(const const_iterator& other) const {
+
+			if (atEnd() || other.atEnd())
+				return atEnd() && other.atEnd();
+
+			return _index == other._index;
+		}
+
+		void increment() { _index++; }
+
+		bool atEnd() const { return _index >= _size; }
+
+		boost::shared_ptr<Storage> _storage;
+
+		// the size of the storage when this iterator was created
+		unsigned int _size;
+
+		unsigned int _index;
+	};
+
+	FlatInputs() :
+		_storage(boost::make_shared<Storage>(0)),
+		_internalConnected(false) {
+
+		_internalSender.registerSlot(_inputAdded);
+		_internalSender.registerSlot(_inputAddedToSharedPointer);
+		_internalSender.registerSlot(_inputsCleared);
+	}
+
+	/**
+	 * Reserve memory for the given number of inputs.
+	 */
+	void reserve(unsigned int size) {
+
+		boost::mutex::scoped_lock lock(_storageMutex);
+
+		if (size > _storage->data.size())
+			grow(size);
+
+		_connections.reserve(size);
+	}
+
+	bool accept(OutputBase& output) {
+
+		addConnection(output).connect(output);
+
+		addedOutput();
+
+		return true;
+	}
+
+	/**
+	 * Add an output whose type is known at compile time. See
+	 * InputImpl::acceptTyped().
+	 */
+	template <typename OutputDataType>
+	bool acceptTyped(OutputImpl<OutputDataType>& output) {
+
+		addConnection(output).connectTyped(output);
+
+		addedOutput();
+
+		return true;
+	}
+
+	bool accept(boost::shared_ptr<Data> data) {
+
+		boost::shared_ptr<DataType> castedData = castData(data);
+
+		append(castedData);
+		_connections.push_back(boost::shared_ptr<Connection>());
+
+		connectInternal();
+
+		PIPELINE_LOG_ALL(pipelinelog) << "[" << typeName(this) << "] sending InputAddedToSharedPointer" << std::endl;
+
+		_inputAddedToSharedPointer(InputAddedToSharedPointer<DataType>(castedData));
+
+		return true;
+	}
+
+	void clear() {
+
+		foreach (signals::SlotsBase* slots, getSlots())
+			slots->clear();
+
+		_connections.clear();
+
+		{
+			boost::mutex::scoped_lock lock(_storageMutex);
+
+			boost::atomic_store(&_storage, boost::make_shared<Storage>(0));
+		}
+
+		_inputsCleared();
+	}
+
+	/**
+	 * Get the data of one of the inputs. Every call loads the current 
+	 * storage, therefore loops over all inputs should use the iterators.
+	 *
+	 * @return The data of input i, or an empty pointer if there is no such 
+	 *         input (e.g., because the inputs were cleared in between).
+	 */
+	boost::shared_ptr<DataType> operator[](unsigned int i) const {
+
+		boost::shared_ptr<Storage> storage = boost::atomic_load(&_storage);
+
+		if (i >= storage->size.load(boost::memory_order_acquire))
+			return boost::shared_ptr<DataType>();
+
+		return boost::atomic_load(&storage->data[i]);
+	}
+
+	const_iterator begin() const {
+
+		return const_iterator(boost::atomic_load(&_storage), 0);
+	}
+
+	const_iterator end() const {
+
+		return const_iterator();
+	}
+
+	unsigned int size() const {
+
+		return boost::atomic_load(&_storage)->size.load(boost::memory_order_acquire);
+	}
+
+	operator bool() const {
+
+		return size() > 0;
+	}
+
+	bool isSet() {
+
+		return size() > 0;
+	}
+
+	OutputBase* getAssignedOutput(unsigned int i) const {
+
+		if (!_connections[i] || !_connections[i]->hasAssignedOutput())
+			return 0;
+
+		return &_connections[i]->getAssignedOutput();
+	}
+
+	using MultiInput::getAssignedOutput;
+
+	boost::shared_ptr<Data> getSharedDataPointer(unsigned int i) const {
+
+		return (*this)[i];
+	}
+
+	void releaseData(unsigned int i) {
+
+		// inputs set to a data pointer would not get their data back
+		if (i < _connections.size() && _connections[i])
+			setData(i, boost::shared_ptr<DataType>());
+	}
+
+	using MultiInput::releaseData;
+
+private:
+
+	boost::shared_ptr<DataType> castData(boost::shared_ptr<Data> data) {
+
+		boost::shared_ptr<DataType> castedData = boost::dynamic_pointer_cast<DataType>(data);
+
+		if (data && !castedData)
+			UTIL_THROW_EXCEPTION(
+					AssignmentError,
+					"pointer of type " << typeName(*data) << " can not be assigned to input of type " << typeName(*this));
+
+		return castedData;
+	}
+
+	Connection& addConnection(OutputBase& output) {
+
+		unsigned int index = append(boost::shared_ptr<DataType>());
+
+		_connections.push_back(boost::make_shared<Connection>(boost::ref(*this), index));
+
+		Connection& connection = *_connections.back();
+
+		// the backwards slots and the callbacks are registered with the
+		// connection, such that they are bound to its index
+		foreach (signals::SlotsBase* slots, getSlots())
+			connection.registerSlot((*slots)[slots->addSlot()]);
+
+		typedef std::pair<CallbacksBase*, ProcessNode*> cp_pair;
+		foreach (cp_pair pair, getMultiCallbacks()) {
+
+			if (pair.second)
+				pair.first->registerAtInput(connection, index, pair.second);
+			else
+				pair.first->registerAtInput(connection, index);
+		}
+
+		connectInternal();
+
+		// signalling connections to the slots and callbacks of the
+		// multi-input itself
+		output.getSender().connect(getReceiver());
+		getSender().connect(output.getReceiver());
+
+		return connection;
+	}
+
+	void addedOutput() {
+
+		PIPELINE_LOG_ALL(pipelinelog) << "[" << typeName(this) << "] sending InputAdded" << std::endl;
+
+		_inputAdded(InputAdded<DataType>((*this)[size() - 1]));
+	}
+
+	void connectInternal() {
+
+		if (_internalConnected)
+			return;
+
+		_internalSender.connect(getReceiver());
+		_internalConnected = true;
+	}
+
+	void setData(unsigned int index, boost::shared_ptr<Data> data) {
+
+		setData(index, castData(data));
+	}
+
+	void setData(unsigned int index, boost::shared_ptr<DataType> data) {
+
+		// the storage must not be replaced in between, otherwise the new data 
+		// would be lost in the old storage
+		boost::mutex::scoped_lock lock(_storageMutex);
+
+		// the inputs were cleared in between
+		if (index >= _storage->size)
+			return;
+
+		// replaced atomically, since double buffered outputs publish new data
+		// while readers access the old one
+		boost::atomic_store(&_storage->data[index], data);
+	}
+
+	// add an input and return its index
+	unsigned int append(boost::shared_ptr<DataType> data) {
+
+		boost::mutex::scoped_lock lock(_storageMutex);
+
+		unsigned int index = _storage->size;
+
+		if (index == _storage->data.size())
+			grow(std::max(2*index, 16u));
+
+		boost::atomic_store(&_storage->data[index], data);
+
+		// publishes the new element to readers
+		_storage->size.store(index + 1, boost::memory_order_release);
+
+		return index;
+	}
+
+	// replace the storage by a larger copy, assumes that _storageMutex is 
+	// locked
+	void grow(unsigned int capacity) {
+
+		boost::shared_ptr<Storage> storage = boost::make_shared<Storage>(capacity);
+
+		unsigned int size = _storage->size;
+
+		for (unsigned int i = 0; i < size; i++)
+			storage->data[i] = boost::atomic_load(&_storage->data[i]);
+
+		storage->size = size;
+
+		// readers of the old storage keep it alive
+		boost::atomic_store(&_storage, storage);
+	}
+
+	// inherited from InputBase, but not used in FlatInputs
+	boost::shared_ptr<Data> getSharedDataPointer() const {
+
+		return boost::shared_ptr<Data>();
+	}
+
+	// the data of all inputs, replaced atomically when it grows
+	boost::shared_ptr<Storage> _storage;
+
+	// serializes changes to the storage
+	boost::mutex _storageMutex;
+
+	// the connection for each input, null for inputs set to a data pointer
+	std::vector<boost::shared_ptr<Connection> > _connections;
+
+	signals::Slot<const InputAdded<DataType> >                _inputAdded;
+	signals::Slot<const InputAddedToSharedPointer<DataType> > _inputAddedToSharedPointer;
+	signals::Slot<const InputsCleared>                        _inputsCleared;
+
+	signals::Sender _internalSender;
+
+	bool _internalConnected;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_FLAT_INPUTS_H__
+
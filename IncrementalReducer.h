@@ -0,0 +1,157 @@
+#ifndef PIPELINE_INCREMENTAL_REDUCER_H__
+#define PIPELINE_INCREMENTAL_REDUCER_H__
+
+#include <string>
+
+#include <util/foreach.h>
+#include "Inputs.h"
+#include "MultiInputChanges.h"
+#include "SimpleProcessNode.h"
+
+namespace pipeline {
+
+/**
+ * Base class for process nodes that aggregate the inputs of a multi-input,
+ * like sums, unions, or merges. Instead of reducing all inputs on each
+ * update, implementations are told only about the inputs that changed since
+ * the last update, such that the cost of an update is proportional to the
+ * number of changes.
+ *
+ * Implementations keep the state of the reduction and implement
+ *
+ *   resetReduction()  to forget all inputs,
+ *   addInput()        to add the data of a new input,
+ *   updateInput()     to replace the former data of an input, and
+ *   finishReduction() to write the outputs.
+ *
+ * Usage example:
+ *
+ * <code>
+ * class Sum : public IncrementalReducer<double> {
+ *
+ * public:
+ *
+ *   Sum() { registerOutput(_sum, "sum"); }
+ *
+ * private:
+ *
+ *   void resetReduction() { _values.clear(); _total = 0; }
+ *
+ *   void addInput(unsigned int, const double& value) { _values.push_back(value); _total += value; }
+ *
+ *   void updateInput(unsigned int i, const double& value) { _total += value - _values[i]; _values[i] = value; }
+ *
+ *   void finishReduction() { _sum = new double(_total); }
+ *
+ *   Output<double>      _sum;
+ *   std::vector<double> _values;
+ *   double              _total;
+ * };
+ * </code>
+ *
+ * Added inputs are reported in the order of their indices. If the
+ * reduction throws, its state is unknown. Therefore, the next update starts
+ * over with resetReduction() and adds all current inputs again.
+ *
+ * Single inputs can not be removed from a multi-input, the InputRemoved
+ * signal is not supported. To remove inputs, clear the multi-input and add
+ * the remaining ones again, which is reported as resetReduction() followed
+ * by addInput() for each of them.
+ */
+template <typename T, class LockingStrategy = FullLockingStrategy>
+class IncrementalReducer : public SimpleProcessNode<LockingStrategy> {
+
+protected:
+
+	/**
+	 * Create a reducer with a multi-input of the given name.
+	 */
+	IncrementalReducer(const std::string& name = "inputs") :
+		_reduced(true),
+		_numReduced(0) {
+
+		this->registerInputs(_inputs, name);
+	}
+
+	/**
+	 * Get the multi-input that is reduced.
+	 */
+	Inputs<T>& getInputs() { return _inputs; }
+
+	/**
+	 * Forget all inputs. Called before the inputs are added again, after the
+	 * multi-input was cleared or a reduction failed.
+	 */
+	virtual void resetReduction() = 0;
+
+	/**
+	 * Add the data of input i to the reduction.
+	 */
+	virtual void addInput(unsigned int i, const T& data) = 0;
+
+	/**
+	 * Replace the former data of input i by its current data.
+	 */
+	virtual void updateInput(unsigned int i, const T& data) = 0;
+
+	/**
+	 * Write the result of the reduction to the outputs. Called once per
+	 * update, after all changes have been reported.
+	 */
+	virtual void finishReduction() = 0;
+
+private:
+
+	void updateOutputs() {
+
+		const MultiInputChanges& changes = this->getChanges(_inputs);
+
+		// the changes are reported again after a failure, but some of them
+		// might have been applied already
+		bool rebuild = (changes.isCleared() || !_reduced);
+
+		_reduced = false;
+
+		// inputs added after the changes were taken are reported by the next
+		// update
+		unsigned int numInputs = (changes.isCleared() ? 0 : _numReduced);
+
+		if (changes.getNumAdded() > 0)
+			numInputs = changes.getFirstAdded() + changes.getNumAdded();
+
+		if (rebuild) {
+
+			resetReduction();
+
+			for (unsigned int i = 0; i < numInputs; i++)
+				addInput(i, *_inputs[i]);
+
+		} else {
+
+			foreach (unsigned int i, changes.getModified())
+				updateInput(i, *_inputs[i]);
+
+			for (unsigned int i = changes.getFirstAdded(); i < changes.getFirstAdded() + changes.getNumAdded(); i++)
+				addInput(i, *_inputs[i]);
+		}
+
+		finishReduction();
+
+		_reduced    = true;
+		_numReduced = numInputs;
+	}
+
+	Inputs<T> _inputs;
+
+	// the last reduction completed, the state of the implementation reflects
+	// all inputs up to the current changes
+	bool _reduced;
+
+	// the number of inputs the last completed reduction covered
+	unsigned int _numReduced;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_INCREMENTAL_REDUCER_H__
+
@@ -0,0 +1,227 @@
+#ifndef PIPELINE_INLINE_VALUE_H__
+#define PIPELINE_INLINE_VALUE_H__
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/type_traits.hpp>
+
+#include <signals/Callback.h>
+#include <signals/Slot.h>
+#include <pipeline/signals/all.h>
+#include "Input.h"
+
+namespace pipeline {
+
+/**
+ * A lightweight alternative to Value for small, trivially copyable types like
+ * parameters. In contrast to Value, an InlineValue does not create a process
+ * node. A fixed value is stored inline, and reading a value that is not
+ * connected to an output, or whose output was not modified since the last
+ * read, costs only atomic loads.
+ *
+ * An InlineValue can be connected to the output of a process node. Modified
+ * signals of the output mark the value dirty, the next read sends an Update
+ * signal and copies the data of the output.
+ *
+ * Usage example:
+ *
+ *   InlineValue<double> threshold(0.5);
+ *
+ *   double t = threshold;
+ *
+ *   threshold = thresholdEstimator->getOutput();
+ *
+ * Unlike Value, an InlineValue can not be used as the input of another
+ * process node.
+ */
+template <typename T>
+class InlineValue : public boost::noncopyable {
+
+	BOOST_STATIC_ASSERT((!boost::is_base_of<Data, T>::value));
+	BOOST_STATIC_ASSERT((boost::has_trivial_copy<T>::value));
+
+	typedef signals::Callback<const Modified, signals::WeakTracking<signals::CallbackBase> >     ModifiedCallbackType;
+	typedef signals::Callback<const InputSetBase, signals::WeakTracking<signals::CallbackBase> > InputSetCallbackType;
+
+public:
+
+	/**
+	 * Create a value initialized with T().
+	 */
+	InlineValue() :
+		_value(T()),
+		_state(Clean) {
+
+		init();
+	}
+
+	/**
+	 * Create a value with a fixed content.
+	 */
+	InlineValue(const T& value) :
+		_value(value),
+		_state(Clean) {
+
+		init();
+	}
+
+	/**
+	 * Create a value from the output of a process node.
+	 */
+	InlineValue(OutputBase& output) :
+		_value(T()),
+		_state(Clean) {
+
+		init();
+
+		operator=(output);
+	}
+
+	/**
+	 * Set this value to a fixed content. Disconnects the value from an output.
+	 */
+	InlineValue<T>& operator=(const T& value) {
+
+		boost::mutex::scoped_lock lock(_updateMutex);
+
+		if (_input.hasAssignedOutput())
+			_input.unset();
+
+		_value = value;
+		_state = Clean;
+
+		return *this;
+	}
+
+	/**
+	 * Connect this value to the output of a process node.
+	 */
+	InlineValue<T>& operator=(OutputBase& output) {
+
+		boost::mutex::scoped_lock lock(_updateMutex);
+
+		_input.accept(output);
+		_state = Dirty;
+
+		return *this;
+	}
+
+	/**
+	 * Get the current value. Updates the assigned output, if it was modified.
+	 */
+	T get() {
+
+		if (_state.load(boost::memory_order_acquire) != Clean)
+			update();
+
+		return _value.load(boost::memory_order_acquire);
+	}
+
+	operator T() { return get(); }
+
+	T operator*() { return get(); }
+
+	/**
+	 * Returns true, if this value is connected to an output.
+	 */
+	bool isConnected() const { return _input.hasAssignedOutput(); }
+
+private:
+
+	enum State {
+
+		Clean,
+
+		Dirty,
+
+		// an update is running, a Modified signal received meanwhile moves the
+		// state to Dirty again
+		Updating
+	};
+
+	void init() {
+
+		_modifiedCallback.reset(new ModifiedCallbackType(boost::bind(&InlineValue<T>::onModified, this, _1), signals::Transparent));
+		_modifiedCallback->track(_modifiedCallback);
+
+		_inputSetCallback.reset(new InputSetCallbackType(boost::bind(&InlineValue<T>::onInputSet, this, _1), signals::Transparent));
+		_inputSetCallback->track(_inputSetCallback);
+
+		_input.registerCallback(*_modifiedCallback);
+		_input.registerCallback(*_inputSetCallback);
+		_input.registerSlot(_update);
+	}
+
+	void update() {
+
+		boost::mutex::scoped_lock lock(_updateMutex);
+
+		// another reader updated in the meantime
+		if (_state == Clean)
+			return;
+
+		// a Modified signal received from now on happens after the update
+		// request, and therefore leaves us dirty
+		_state = Updating;
+
+		try {
+
+			_update();
+
+			// the output might not have data, yet
+			boost::shared_ptr<Wrap<T> > data = _input.InputImpl<Wrap<T> >::getSharedPointer();
+
+			if (data) {
+
+				boost::shared_lock<boost::shared_mutex> dataLock(data->getMutex());
+
+				if (data->get())
+					_value.store(*data->get(), boost::memory_order_release);
+			}
+
+		} catch (...) {
+
+			_state = Dirty;
+			throw;
+		}
+
+		int updating = Updating;
+		_state.compare_exchange_strong(updating, Clean, boost::memory_order_release);
+	}
+
+	void onModified(const Modified&) {
+
+		_state = Dirty;
+	}
+
+	void onInputSet(const InputSetBase&) {
+
+		_state = Dirty;
+	}
+
+	// the input to receive signals from an assigned output
+	Input<T> _input;
+
+	signals::Slot<Update> _update;
+
+	boost::shared_ptr<ModifiedCallbackType> _modifiedCallback;
+	boost::shared_ptr<InputSetCallbackType> _inputSetCallback;
+
+	// the last known content
+	boost::atomic<T> _value;
+
+	boost::atomic<int> _state;
+
+	// serializes updates, assignments, and connections
+	boost::mutex _updateMutex;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_INLINE_VALUE_H__
+
@@ -7,6 +7,12 @@ namespace pipeline {
 InputBase::InputBase() :
 	_assignedOutput(0) {}
 
+InputBase::~InputBase() {
+
+	if (_outputConsumers)
+		(*_outputConsumers)--;
+}
+
 void
 InputBase::registerSlot(signals::SlotBase& slot) {
 
@@ -28,24 +34,41 @@ InputBase::hasAssignedOutput() const {
 OutputBase&
 InputBase::getAssignedOutput() const {
 
+	OutputBase* output = _assignedOutput;
+
 #ifndef NDEBUG
-	if (_assignedOutput == 0)
+	if (output == 0)
 		UTIL_THROW_EXCEPTION(NullPointer, "This input does not have an assigned output");
 #endif
 
-	return *_assignedOutput;
+	return *output;
 }
 
 void
 InputBase::setAssignedOutput(OutputBase& output) {
 
+	if (_outputConsumers)
+		(*_outputConsumers)--;
+
+	_outputConsumers = output._numConsumers;
+	(*_outputConsumers)++;
+
 	_assignedOutput = &output;
+
+	OutputBase::nextConnectionEpoch();
 }
 
 void
 InputBase::unsetAssignedOutput() {
 
+	if (_outputConsumers)
+		(*_outputConsumers)--;
+
+	_outputConsumers.reset();
+
 	_assignedOutput = 0;
+
+	OutputBase::nextConnectionEpoch();
 }
 
 signals::Sender&
@@ -1,6 +1,9 @@
 #ifndef PIPELINE_INPUT_H__
 #define PIPELINE_INPUT_H__
 
+#include <boost/atomic.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/type_traits.hpp>
 
 #include <signals/Callback.h>
@@ -21,6 +24,11 @@ public:
 
 	InputBase();
 
+	/**
+	 * Leaves the assigned output, if any.
+	 */
+	virtual ~InputBase();
+
 	/**
 	 * Register a slot for backward signals with this input.
 	 *
@@ -161,6 +169,26 @@ public:
 	 */
 	virtual void unset() = 0;
 
+	/**
+	 * Release the reference of this input to its data, but stay connected to 
+	 * the assigned output. The data is set again when the output gets new 
+	 * data. The default implementation does nothing.
+	 */
+	virtual void releaseData() {}
+
+	/**
+	 * Keep the data of this input until unpinData() is called. New data set 
+	 * on the assigned output meanwhile is taken over by unpinData(). The 
+	 * default implementation does nothing.
+	 */
+	virtual void pinData() {}
+
+	/**
+	 * Release the data pinned by pinData(), and take over the current data of 
+	 * the assigned output, if it was changed meanwhile.
+	 */
+	virtual void unpinData() {}
+
 	/**
 	 * Returns true, if this input is assigned.
 	 */
@@ -188,8 +216,12 @@ private:
 	// (exclusive ownership)
 	std::vector<boost::shared_ptr<signals::CallbackBase> > _callbacks;
 
-	// the currently assigned output to this input (null, if not assigned)
-	OutputBase* _assignedOutput;
+	// the currently assigned output to this input (null, if not assigned), 
+	// can be read while the input is rewired
+	boost::atomic<OutputBase*> _assignedOutput;
+
+	// the consumer count of the assigned output
+	boost::shared_ptr<boost::atomic<unsigned int> > _outputConsumers;
 };
 
 template <typename DataType>
@@ -200,6 +232,9 @@ class InputImpl : public InputBase {
 public:
 
 	InputImpl() :
+		_getTypedData(0),
+		_pinned(false),
+		_pinnedOutputChanged(false),
 		_inputSet(boost::make_shared<signals::Slot<const InputSet<DataType> > >()),
 		_inputSetToSharedPointer(boost::make_shared<signals::Slot<const InputSetToSharedPointer<DataType> > >()),
 		_inputUnset(boost::make_shared<signals::Slot<const InputUnset<DataType> > >()),
@@ -219,24 +254,30 @@ public:
 
 	bool accept(OutputBase& output) {
 
-		// establish input-output signalling connections
-		output.getSender().connect(getReceiver());
-		getSender().connect(output.getReceiver());
+		_getTypedData = 0;
 
-		// establish the internal signalling connections
-		_internalSender.connect(getReceiver());
+		return connect(output);
+	}
 
-		// remember what output we are using
-		setAssignedOutput(output);
+	/**
+	 * Accept an output whose type is known at compile time. The compatibility 
+	 * of the data types is verified by the compiler, therefore data set on 
+	 * the output will be assigned to this input without a runtime type check.
+	 */
+	template <typename OutputDataType>
+	bool acceptTyped(OutputImpl<OutputDataType>& output) {
 
-		// if there is already data on the output
-		setDataFromOutput(output.getSharedDataPointer());
+		BOOST_STATIC_ASSERT((boost::is_convertible<OutputDataType*, DataType*>::value));
 
-		return true;
+		_getTypedData = &getTypedData<OutputDataType>;
+
+		return connect(output);
 	}
 
 	bool accept(boost::shared_ptr<Data> data) {
 
+		_getTypedData = 0;
+
 		// establish the internal signalling connections
 		_internalSender.connect(getReceiver());
 
@@ -250,11 +291,13 @@ public:
 
 	void unset() {
 
+		_getTypedData = 0;
+
 		// get a shared pointer to the data for the signal
-		boost::shared_ptr<DataType> oldData = _data;
+		boost::shared_ptr<DataType> oldData = boost::atomic_load(&_data);
 
 		// reset shared pointer to data
-		_data.reset();
+		boost::atomic_store(&_data, boost::shared_ptr<DataType>());
 
 		if (hasAssignedOutput()) {
 
@@ -275,7 +318,7 @@ public:
 	 */
 	boost::shared_ptr<Data> getSharedDataPointer() const {
 
-		return _data;
+		return boost::atomic_load(&_data);
 	}
 
 	/**
@@ -284,7 +327,7 @@ public:
 	 */
 	boost::shared_ptr<DataType> getSharedPointer() const {
 
-		return _data;
+		return boost::atomic_load(&_data);
 	}
 
 	/**
@@ -337,19 +380,70 @@ public:
 		return static_cast<bool>(_data);
 	}
 
+	void releaseData() {
+
+		boost::atomic_store(&_data, boost::shared_ptr<DataType>());
+	}
+
+	void pinData() {
+
+		boost::mutex::scoped_lock lock(_pinMutex);
+
+		_pinned = true;
+	}
+
+	void unpinData() {
+
+		boost::mutex::scoped_lock lock(_pinMutex);
+
+		_pinned = false;
+
+		if (!_pinnedOutputChanged)
+			return;
+
+		_pinnedOutputChanged = false;
+
+		if (hasAssignedOutput())
+			setData(getAssignedOutput());
+	}
+
 	/**
 	 * For convencience, implicit conversion to shared pointer to DataType.
 	 */
 	operator boost::shared_ptr<DataType>() const {
 
-		return _data;
+		return boost::atomic_load(&_data);
 	}
 
 private:
 
-	void setDataFromOutput(boost::shared_ptr<Data> data) {
+	bool connect(OutputBase& output) {
 
-		setData(data);
+		// establish input-output signalling connections
+		output.getSender().connect(getReceiver());
+		getSender().connect(output.getReceiver());
+
+		// establish the internal signalling connections
+		_internalSender.connect(getReceiver());
+
+		// remember what output we are using
+		setAssignedOutput(output);
+
+		// if there is already data on the output
+		setDataFromOutput(output);
+
+		return true;
+	}
+
+	template <typename OutputDataType>
+	static boost::shared_ptr<DataType> getTypedData(OutputBase& output) {
+
+		return static_cast<OutputImpl<OutputDataType>&>(output).getPublishedPointer();
+	}
+
+	void setDataFromOutput(OutputBase& output) {
+
+		setData(output);
 
 		// inform about new input
 		(*_inputSet)(InputSet<DataType>(_data));
@@ -367,7 +461,7 @@ private:
 
 		if (!data) {
 
-			_data.reset();
+			boost::atomic_store(&_data, boost::shared_ptr<DataType>());
 			return;
 		}
 
@@ -378,18 +472,52 @@ private:
 					AssignmentError,
 					"pointer of type " << typeName(*data) << " can not be assigned to input of type " << typeName(*this));
 
-		// share ownership to make sure the input data keeps alive
-		_data = castedData;
+		// share ownership to make sure the input data keeps alive, the pointer 
+		// is replaced atomically since double buffered outputs publish new 
+		// data while readers access the old one
+		boost::atomic_store(&_data, castedData);
+	}
+
+	void setData(OutputBase& output) {
+
+		// the data types of statically typed connections have been verified 
+		// by the compiler already
+		if (_getTypedData)
+			boost::atomic_store(&_data, _getTypedData(output));
+		else
+			setData(output.getSharedDataPointer());
 	}
 
 	void onOutputPointerSet(const OutputPointerSet&) {
 
-		setData(getAssignedOutput().getSharedDataPointer());
+		boost::mutex::scoped_lock lock(_pinMutex);
+
+		// the data is read by an update, take it over when it is unpinned
+		if (_pinned) {
+
+			_pinnedOutputChanged = true;
+			return;
+		}
+
+		setData(getAssignedOutput());
 	}
 
+	// gets the data of the assigned output without a runtime type check, set 
+	// if this input was connected with acceptTyped()
+	boost::shared_ptr<DataType> (*_getTypedData)(OutputBase&);
+
 	// inputs share ownership of input data
 	boost::shared_ptr<DataType> _data;
 
+	// set between pinData() and unpinData(), while _data must not change
+	bool _pinned;
+
+	// the assigned output got new data while _data was pinned
+	bool _pinnedOutputChanged;
+
+	// serializes pinning with data changes of the assigned output
+	boost::mutex _pinMutex;
+
 	// slot to send a signal when the input was set
 	boost::shared_ptr<signals::Slot<const InputSet<DataType> > > _inputSet;
 
@@ -157,6 +157,41 @@ public:
 	 */
 	void unset() { clear(); }
 
+	/**
+	 * Get the current number of inputs.
+	 */
+	virtual unsigned int size() const = 0;
+
+	/**
+	 * Get the output assigned to one of the inputs of this multi-input.
+	 *
+	 * @param i The number of the input.
+	 * @return The assigned output, or 0 if the input was set to a data 
+	 *         pointer.
+	 */
+	virtual OutputBase* getAssignedOutput(unsigned int i) const = 0;
+
+	using InputBase::getAssignedOutput;
+
+	/**
+	 * Get the data assigned to one of the inputs of this multi-input.
+	 *
+	 * @param i The number of the input.
+	 */
+	virtual boost::shared_ptr<Data> getSharedDataPointer(unsigned int i) const = 0;
+
+	using InputBase::getSharedDataPointer;
+
+	/**
+	 * Release the reference of one of the inputs to its data, see 
+	 * InputBase::releaseData().
+	 *
+	 * @param i The number of the input.
+	 */
+	virtual void releaseData(unsigned int i) = 0;
+
+	using InputBase::releaseData;
+
 protected:
 
 	/**
@@ -257,6 +292,16 @@ public:
 		return __accept(data);
 	}
 
+	/**
+	 * Add an output whose type is known at compile time. See 
+	 * InputImpl::acceptTyped().
+	 */
+	template <typename OutputDataType>
+	bool acceptTyped(OutputImpl<OutputDataType>& output) {
+
+		return __accept(output);
+	}
+
 	void clear() {
 
 		// clear the slots
@@ -321,6 +366,41 @@ public:
 		return size() > 0;
 	}
 
+	/**
+	 * Get the output assigned to one of the inputs of this multi-input.
+	 *
+	 * @param i The number of the input.
+	 * @return The assigned output, or 0 if the input was set to a data 
+	 *         pointer.
+	 */
+	OutputBase* getAssignedOutput(unsigned int i) const {
+
+		if (!_inputs[i]->hasAssignedOutput())
+			return 0;
+
+		return &_inputs[i]->getAssignedOutput();
+	}
+
+	using MultiInput::getAssignedOutput;
+
+	/**
+	 * Get the data assigned to one of the inputs of this multi-input.
+	 *
+	 * @param i The number of the input.
+	 */
+	boost::shared_ptr<Data> getSharedDataPointer(unsigned int i) const {
+
+		return _inputs[i]->getSharedDataPointer();
+	}
+
+	void releaseData(unsigned int i) {
+
+		if (i < _inputs.size())
+			_inputs[i]->releaseData();
+	}
+
+	using MultiInput::releaseData;
+
 private:
 
 	/**
@@ -336,7 +416,7 @@ private:
 		boost::shared_ptr<Input<DataType> > newInput(new Input<DataType>());
 
 		// store it, if it is compatible
-		if (newInput->accept(output)) {
+		if (acceptInput(*newInput, output)) {
 
 			PIPELINE_LOG_ALL(pipelinelog) << "[" << typeName(this) << "] I can accept it" << std::endl;
 
@@ -389,6 +469,22 @@ private:
 		return false;
 	}
 
+	static bool acceptInput(Input<DataType>& input, OutputBase& output) {
+
+		return input.accept(output);
+	}
+
+	static bool acceptInput(Input<DataType>& input, boost::shared_ptr<Data> data) {
+
+		return input.accept(data);
+	}
+
+	template <typename OutputDataType>
+	static bool acceptInput(Input<DataType>& input, OutputImpl<OutputDataType>& output) {
+
+		return input.acceptTyped(output);
+	}
+
 	void establishingSignalling(OutputBase& output, Input<DataType>& newInput) {
 
 		// establish input-output signalling connections to Slots
@@ -0,0 +1,150 @@
+#ifndef PIPELINE_LAZY_SLOTS_H__
+#define PIPELINE_LAZY_SLOTS_H__
+
+#include <vector>
+
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <signals/Sender.h>
+#include <signals/Slot.h>
+#include "Inputs.h"
+
+namespace pipeline {
+
+/**
+ * Backward slots for the inputs of a multi-input, which are created and
+ * connected to the assigned outputs the first time a signal is sent through
+ * them. In contrast to signals::Slots registered via
+ * MultiInput::registerSlots(), adding an input to the multi-input does not
+ * create or connect anything. Use this for signals that most of the inputs
+ * never send.
+ *
+ * A slot is connected to the output that is assigned to its input when the
+ * slot is needed first. If the input gets assigned to another output later
+ * (i.e., after the multi-input was cleared), the slot is replaced on the
+ * next use.
+ *
+ * Usage example:
+ *
+ *   LazySlots<Update> _updates(_inputs);
+ *
+ *   for (unsigned int i = 0; i < _updates.size(); i++)
+ *     _updates.send(i, signal);
+ */
+template <typename SignalType>
+class LazySlots {
+
+public:
+
+	/**
+	 * Create lazy slots for the given multi-input.
+	 */
+	LazySlots(MultiInput& inputs) :
+		_inputs(inputs) {}
+
+	/**
+	 * Get the number of inputs of the multi-input.
+	 */
+	unsigned int size() const { return _inputs.size(); }
+
+	/**
+	 * Get the slot of an input, connected to the assigned output. The 
+	 * returned pointer keeps the slot alive, even if it gets replaced or 
+	 * cleared meanwhile.
+	 *
+	 * @return The slot, or null if the input is not assigned to an output.
+	 */
+	boost::shared_ptr<signals::Slot<SignalType> > getSlot(unsigned int i) {
+
+		boost::shared_ptr<LazySlot> slot = materialize(i);
+
+		if (!slot)
+			return boost::shared_ptr<signals::Slot<SignalType> >();
+
+		// shares the ownership of the whole lazy slot
+		return boost::shared_ptr<signals::Slot<SignalType> >(slot, &slot->slot);
+	}
+
+	/**
+	 * Send a signal through the slot of an input.
+	 *
+	 * @return False, if the input is not assigned to an output.
+	 */
+	bool send(unsigned int i, SignalType& signal) {
+
+		// keeps the slot alive, even if it gets replaced meanwhile
+		boost::shared_ptr<LazySlot> slot = materialize(i);
+
+		if (!slot)
+			return false;
+
+		slot->slot(signal);
+
+		return true;
+	}
+
+	/**
+	 * Release all slots, e.g., after the multi-input was cleared.
+	 */
+	void clear() {
+
+		boost::mutex::scoped_lock lock(_mutex);
+
+		_slots.clear();
+	}
+
+private:
+
+	struct LazySlot {
+
+		LazySlot() : output(0) {}
+
+		// the output the slot is connected to
+		OutputBase* output;
+
+		signals::Slot<SignalType> slot;
+		signals::Sender           sender;
+	};
+
+	boost::shared_ptr<LazySlot> materialize(unsigned int i) {
+
+		if (i >= _inputs.size())
+			return boost::shared_ptr<LazySlot>();
+
+		OutputBase* output = _inputs.getAssignedOutput(i);
+
+		if (!output)
+			return boost::shared_ptr<LazySlot>();
+
+		boost::mutex::scoped_lock lock(_mutex);
+
+		if (i >= _slots.size())
+			_slots.resize(i + 1);
+
+		boost::shared_ptr<LazySlot>& slot = _slots[i];
+
+		if (!slot || slot->output != output) {
+
+			slot = boost::make_shared<LazySlot>();
+			slot->output = output;
+			slot->sender.registerSlot(slot->slot);
+			slot->sender.connect(output->getReceiver());
+		}
+
+		return slot;
+	}
+
+	MultiInput& _inputs;
+
+	// the slots created so far, null for inputs that did not send yet
+	std::vector<boost::shared_ptr<LazySlot> > _slots;
+
+	boost::mutex _mutex;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_LAZY_SLOTS_H__
+
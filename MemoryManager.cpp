@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include "Logging.h"
+#include "MemoryManager.h"
+#include "ProcessNode.h"
+
+logger::LogChannel memorymanagerlog("memorymanagerlog", "[MemoryManager] ");
+
+namespace pipeline {
+
+util::ProgramOption optionMemoryBudget(
+		util::_module           = "pipeline",
+		util::_long_name        = "memoryBudget",
+		util::_description_text = "The maximal size of the outputs of evictable process nodes in MB. If exceeded, outputs "
+		                          "are released and recomputed when needed again. 0 disables the budget.",
+		util::_default_value    = 0);
+
+namespace {
+
+std::size_t budget() {
+
+	static std::size_t budget = static_cast<std::size_t>(optionMemoryBudget.as<double>()*1024*1024);
+
+	return budget;
+}
+
+// eviction candidate with its score
+struct Candidate {
+
+	double             score;
+	EvictableOutputs*  owner;
+
+	bool operator<(const Candidate& other) const { return score < other.score; }
+};
+
+} // anonymous namespace
+
+bool
+MemoryManager::isEnabled() {
+
+	static bool enabled = (budget() > 0);
+
+	return enabled;
+}
+
+MemoryManager&
+MemoryManager::getInstance() {
+
+	static MemoryManager instance(budget());
+
+	return instance;
+}
+
+MemoryManager::MemoryManager(std::size_t budget) :
+	_budget(budget),
+	_usage(0),
+	_clock(0) {}
+
+void
+MemoryManager::update(EvictableOutputs* owner, boost::weak_ptr<ProcessNode> processNode, std::size_t size, Profiler::time_type cost) {
+
+	// Process nodes are kept alive during eviction and released after the 
+	// mutex, since their destruction calls remove().
+	std::vector<boost::shared_ptr<ProcessNode> > alive;
+
+	boost::mutex::scoped_lock lock(_mutex);
+
+	std::map<EvictableOutputs*, Entry>::iterator i = _entries.find(owner);
+
+	if (i == _entries.end()) {
+
+		Entry entry;
+		entry.size = 0;
+		entry.cost = 0;
+
+		i = _entries.insert(std::make_pair(owner, entry)).first;
+	}
+
+	Entry& entry = i->second;
+
+	_usage = _usage - entry.size + size;
+
+	entry.processNode = processNode;
+	entry.size        = size;
+	entry.lastUse     = ++_clock;
+
+	if (cost > 0)
+		entry.cost = cost;
+
+	if (_usage > _budget)
+		enforceBudget(owner, alive);
+}
+
+void
+MemoryManager::used(EvictableOutputs* owner) {
+
+	boost::mutex::scoped_lock lock(_mutex);
+
+	std::map<EvictableOutputs*, Entry>::iterator i = _entries.find(owner);
+
+	if (i != _entries.end())
+		i->second.lastUse = ++_clock;
+}
+
+void
+MemoryManager::remove(EvictableOutputs* owner) {
+
+	boost::mutex::scoped_lock lock(_mutex);
+
+	std::map<EvictableOutputs*, Entry>::iterator i = _entries.find(owner);
+
+	if (i == _entries.end())
+		return;
+
+	_usage -= i->second.size;
+	_entries.erase(i);
+}
+
+std::size_t
+MemoryManager::getUsage() {
+
+	boost::mutex::scoped_lock lock(_mutex);
+
+	return _usage;
+}
+
+void
+MemoryManager::enforceBudget(EvictableOutputs* keep, std::vector<boost::shared_ptr<ProcessNode> >& alive) {
+
+	std::vector<Candidate> candidates;
+
+	for (std::map<EvictableOutputs*, Entry>::iterator i = _entries.begin(); i != _entries.end(); i++) {
+
+		if (i->first == keep || i->second.size == 0)
+			continue;
+
+		Candidate candidate;
+		candidate.owner = i->first;
+		candidate.score =
+				static_cast<double>(i->second.cost + 1)/
+				(static_cast<double>(i->second.size)*static_cast<double>(_clock - i->second.lastUse + 1));
+
+		candidates.push_back(candidate);
+	}
+
+	std::sort(candidates.begin(), candidates.end());
+
+	for (unsigned int c = 0; c < candidates.size() && _usage > _budget; c++) {
+
+		Entry& entry = _entries[candidates[c].owner];
+
+		boost::shared_ptr<ProcessNode> processNode = entry.processNode.lock();
+
+		// the process node is being destructed
+		if (!processNode)
+			continue;
+
+		alive.push_back(processNode);
+
+		if (!candidates[c].owner->evictOutputs())
+			continue;
+
+		PIPELINE_LOG_ALL(memorymanagerlog) << "released " << entry.size << " bytes" << std::endl;
+
+		_usage -= entry.size;
+		_entries.erase(candidates[c].owner);
+	}
+
+	if (_usage > _budget)
+		LOG_DEBUG(memorymanagerlog)
+				<< "memory budget of " << _budget << " bytes exceeded, "
+				<< _usage << " bytes are in use" << std::endl;
+
+}
+
+} // namespace pipeline
@@ -0,0 +1,128 @@
+#ifndef PIPELINE_MEMORY_MANAGER_H__
+#define PIPELINE_MEMORY_MANAGER_H__
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include "Profiling.h"
+
+namespace pipeline {
+
+// forward declaration
+class ProcessNode;
+
+/**
+ * Interface for process nodes whose outputs can be released by the 
+ * MemoryManager.
+ */
+class EvictableOutputs {
+
+public:
+
+	virtual ~EvictableOutputs() {}
+
+	/**
+	 * Release the data of all outputs and mark them dirty, such that they 
+	 * will be recomputed on the next update.
+	 *
+	 * @return false, if the outputs are in use and can not be released now.
+	 */
+	virtual bool evictOutputs() = 0;
+};
+
+/**
+ * Keeps the memory used by the outputs of evictable process nodes below the 
+ * budget given by the program option 'memoryBudget'. Process nodes report the 
+ * size of their outputs (see Data::getSize()) and the time it took to compute 
+ * them after each update. Whenever the budget is exceeded, outputs are 
+ * released in the order of
+ *
+ *   cost/(size*age),
+ *
+ * i.e., large outputs that have not been used for a long time and are cheap 
+ * to recompute are released first.
+ */
+class MemoryManager {
+
+public:
+
+	/**
+	 * Returns true, if the program option 'memoryBudget' was set.
+	 */
+	static bool isEnabled();
+
+	static MemoryManager& getInstance();
+
+	/**
+	 * Report the size of the outputs of a process node after an update. 
+	 * Releases other outputs, if the budget is exceeded.
+	 *
+	 * @param owner       The outputs.
+	 * @param processNode The process node of the outputs, used to keep it 
+	 *                    alive during eviction.
+	 * @param size        The size of all outputs in bytes.
+	 * @param cost        The time needed to compute the outputs, 0 to keep 
+	 *                    the previous cost.
+	 */
+	void update(EvictableOutputs* owner, boost::weak_ptr<ProcessNode> processNode, std::size_t size, Profiler::time_type cost);
+
+	/**
+	 * Report a read access to the outputs of a process node.
+	 */
+	void used(EvictableOutputs* owner);
+
+	/**
+	 * Stop tracking the outputs of a process node.
+	 */
+	void remove(EvictableOutputs* owner);
+
+	/**
+	 * Get the size of all tracked outputs in bytes.
+	 */
+	std::size_t getUsage();
+
+	/**
+	 * Get the budget in bytes.
+	 */
+	std::size_t getBudget() const { return _budget; }
+
+private:
+
+	struct Entry {
+
+		boost::weak_ptr<ProcessNode> processNode;
+
+		std::size_t         size;
+		Profiler::time_type cost;
+
+		// the value of _clock at the last access
+		boost::uint64_t lastUse;
+	};
+
+	MemoryManager(std::size_t budget);
+
+	// release outputs until the usage is below the budget, assumes that 
+	// _mutex is locked
+	void enforceBudget(EvictableOutputs* keep, std::vector<boost::shared_ptr<ProcessNode> >& alive);
+
+	std::map<EvictableOutputs*, Entry> _entries;
+
+	std::size_t _budget;
+	std::size_t _usage;
+
+	// counts accesses, used as time for the LRU order
+	boost::uint64_t _clock;
+
+	boost::mutex _mutex;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_MEMORY_MANAGER_H__
+
@@ -0,0 +1,138 @@
+#ifndef PIPELINE_MULTI_INPUT_CHANGES_H__
+#define PIPELINE_MULTI_INPUT_CHANGES_H__
+
+#include <set>
+
+#include <util/foreach.h>
+
+namespace pipeline {
+
+/**
+ * The changes of a multi-input since the last update of a process node: the
+ * inputs that were modified, the inputs that were added, and whether the
+ * multi-input was cleared. Added inputs are always appended to a multi-input,
+ * therefore they form a contiguous range of indices.
+ *
+ * Process nodes that aggregate many inputs can use the changes to update
+ * their outputs in time proportional to the number of changed inputs, see
+ * SimpleProcessNode::getChanges() and IncrementalReducer.
+ */
+class MultiInputChanges {
+
+public:
+
+	MultiInputChanges() :
+		_cleared(false),
+		_firstAdded(0),
+		_numAdded(0) {}
+
+	/**
+	 * Returns true, if all the inputs that were present at the last update
+	 * have been removed. In this case, all current inputs are reported as
+	 * added.
+	 */
+	bool isCleared() const { return _cleared; }
+
+	/**
+	 * Get the index of the first added input. Added inputs have the indices
+	 * getFirstAdded(), ..., getFirstAdded() + getNumAdded() - 1.
+	 */
+	unsigned int getFirstAdded() const { return _firstAdded; }
+
+	/**
+	 * Get the number of added inputs.
+	 */
+	unsigned int getNumAdded() const { return _numAdded; }
+
+	/**
+	 * Returns true, if input i was added.
+	 */
+	bool isAdded(unsigned int i) const { return _numAdded > 0 && i >= _firstAdded && i < _firstAdded + _numAdded; }
+
+	/**
+	 * Get the indices of the modified inputs. Added inputs are not reported
+	 * as modified.
+	 */
+	const std::set<unsigned int>& getModified() const { return _modified; }
+
+	/**
+	 * Returns true, if nothing changed.
+	 */
+	bool empty() const { return !_cleared && _numAdded == 0 && _modified.empty(); }
+
+	/**
+	 * Record a modification of input i.
+	 */
+	void setModified(unsigned int i) {
+
+		if (!isAdded(i))
+			_modified.insert(i);
+	}
+
+	/**
+	 * Record that input i was appended to the multi-input.
+	 */
+	void setAdded(unsigned int i) {
+
+		if (_numAdded == 0)
+			_firstAdded = i;
+
+		_numAdded++;
+
+		_modified.erase(i);
+	}
+
+	/**
+	 * Record that the multi-input was cleared. Earlier changes are obsolete.
+	 */
+	void setCleared() {
+
+		_cleared    = true;
+		_firstAdded = 0;
+		_numAdded   = 0;
+		_modified.clear();
+	}
+
+	/**
+	 * Add changes that happened after the changes of this object.
+	 */
+	void merge(const MultiInputChanges& later) {
+
+		if (later._cleared) {
+
+			*this = later;
+			return;
+		}
+
+		for (unsigned int i = later._firstAdded; i < later._firstAdded + later._numAdded; i++)
+			setAdded(i);
+
+		foreach (unsigned int i, later._modified)
+			setModified(i);
+	}
+
+	/**
+	 * Forget all changes.
+	 */
+	void clear() {
+
+		_cleared    = false;
+		_firstAdded = 0;
+		_numAdded   = 0;
+		_modified.clear();
+	}
+
+private:
+
+	bool _cleared;
+
+	unsigned int _firstAdded;
+	unsigned int _numAdded;
+
+	std::set<unsigned int> _modified;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_MULTI_INPUT_CHANGES_H__
+
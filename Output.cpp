@@ -1,8 +1,12 @@
+#include <algorithm>
+
 #include "Output.h"
 #include "ProcessNode.h"
 
 namespace pipeline {
 
+boost::atomic<unsigned int> OutputBase::_connectionEpoch(0);
+
 OutputBase::~OutputBase() {
 
 	// destruct all process node callbacks, that have been registered for
@@ -22,6 +26,26 @@ void
 OutputBase::registerCallback(signals::CallbackBase& callback) {
 
 	_receiver.registerCallback(callback);
+
+	_numCallbacks++;
+	nextConnectionEpoch();
+}
+
+void
+OutputBase::unregisterCallback(signals::CallbackBase& callback) {
+
+	_receiver.unregisterCallback(callback);
+
+	_numCallbacks--;
+	nextConnectionEpoch();
+
+	std::vector<signals::CallbackBase*>::iterator i = std::find(_callbacks.begin(), _callbacks.end(), &callback);
+
+	if (i != _callbacks.end()) {
+
+		delete *i;
+		_callbacks.erase(i);
+	}
 }
 
 signals::Sender&
@@ -3,8 +3,10 @@
 
 #include <iostream>
 
+#include <boost/atomic.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/pool/pool_alloc.hpp>
 
 #include <util/exceptions.h>
 #include <signals/Sender.h>
@@ -12,8 +14,11 @@
 #include <signals/Slot.h>
 #include <signals/Callback.h>
 #include "Data.h"
+#include "DataPool.h"
+#include "exceptions.h"
 #include "Logging.h"
 #include "OutputSignals.h"
+#include "Persistence.h"
 #include "ProcessNodeCallback.h"
 #include "Wrap.h"
 
@@ -26,11 +31,16 @@ class OutputBase {
 
 public:
 
+	struct AssignmentError : virtual PipelineError {};
+
 	/**
 	 * Create a new OutputBase.
 	 */
 	OutputBase() :
-		_pointerSet(new signals::Slot<OutputPointerSet>()) {
+		_pointerSet(new signals::Slot<OutputPointerSet>()),
+		_numConsumers(new boost::atomic<unsigned int>(0)),
+		_numCallbacks(0),
+		_domain(-1) {
 
 		_sender.registerSlot(*_pointerSet);
 	}
@@ -146,6 +156,14 @@ public:
 	 */
 	void registerCallback(signals::CallbackBase& callback);
 
+	/**
+	 * Remove a callback from this output. Callbacks that were created by this 
+	 * output for a process node are deleted.
+	 *
+	 * @param A Callback object that was registered with this output.
+	 */
+	void unregisterCallback(signals::CallbackBase& callback);
+
 	/**
 	 * Add a process node as a dependency of this output.
 	 */
@@ -165,6 +183,90 @@ public:
 	 */
 	virtual boost::shared_ptr<Data> getSharedDataPointer() const = 0;
 
+	/**
+	 * Set the Data instance held by this output. The data has to be of the 
+	 * type of this output.
+	 */
+	virtual void setSharedDataPointer(boost::shared_ptr<Data> data) = 0;
+
+	/**
+	 * Release the reference of this output to its data, without informing the 
+	 * connected inputs. The inputs keep the data until they release it 
+	 * themselves, or the output gets new data.
+	 */
+	virtual void releaseData() = 0;
+
+	/**
+	 * Returns true, if double buffering was enabled for this output.
+	 */
+	virtual bool isDoubleBuffered() const = 0;
+
+	/**
+	 * Part of the double buffering interface used by the 
+	 * DoubleBufferedLockingStrategy. Create a back buffer, which will be 
+	 * accessed by the owning process node instead of the published data until 
+	 * publishBackBuffer() or discardBackBuffer() is called.
+	 */
+	virtual void beginBackBuffer() = 0;
+
+	/**
+	 * Make the back buffer the published data of this output and inform the 
+	 * connected inputs.
+	 */
+	virtual void publishBackBuffer() = 0;
+
+	/**
+	 * Drop the back buffer without publishing it.
+	 */
+	virtual void discardBackBuffer() = 0;
+
+	/**
+	 * Get the content key of data published by this output, see 
+	 * Data::getContentKey(). If the data has no content key but its type 
+	 * provides a Persistence trait, the key is computed from the content. The 
+	 * caller has to hold a read lock on the data.
+	 *
+	 * @param data Data that was published by this output.
+	 * @return The content key, or 0 if it is unknown.
+	 */
+	virtual boost::uint64_t getContentKey(Data& data) const = 0;
+
+	/**
+	 * Get the NUMA domain of the thread pool worker that computed the data of 
+	 * this output most recently, see ThreadPool.
+	 *
+	 * @return The domain, or -1 if it is unknown.
+	 */
+	int getDomain() const { return _domain; }
+
+	/**
+	 * Set the NUMA domain the data of this output was computed on.
+	 */
+	void setDomain(int domain) { _domain = domain; }
+
+	/**
+	 * Get the number of inputs this output is assigned to.
+	 */
+	unsigned int getNumConsumers() const { return *_numConsumers; }
+
+	/**
+	 * Get the number of callbacks registered with this output.
+	 */
+	unsigned int getNumCallbacks() const { return _numCallbacks; }
+
+	/**
+	 * Get the current connection epoch. The epoch changes whenever an input is 
+	 * assigned to or removed from an output, or a callback is registered with 
+	 * an output. It is used to detect changes of the graph that invalidate 
+	 * information derived from the connections.
+	 */
+	static unsigned int getConnectionEpoch() { return _connectionEpoch; }
+
+	/**
+	 * Start a new connection epoch.
+	 */
+	static void nextConnectionEpoch() { _connectionEpoch++; }
+
 protected:
 
 	/**
@@ -175,6 +277,9 @@ protected:
 
 private:
 
+	// inputs count themselves as consumers
+	friend class InputBase;
+
 	signals::Sender   _sender;
 	signals::Receiver _receiver;
 
@@ -187,6 +292,83 @@ private:
 
 	// a slot to send a signal on data pointer changes
 	boost::shared_ptr<signals::Slot<OutputPointerSet> > _pointerSet;
+
+	// the number of inputs assigned to this output, shared with the inputs, 
+	// such that inputs can leave even if this output is gone already
+	boost::shared_ptr<boost::atomic<unsigned int> > _numConsumers;
+
+	// the number of callbacks registered with our receiver
+	boost::atomic<unsigned int> _numCallbacks;
+
+	// the domain the data was computed on
+	boost::atomic<int> _domain;
+
+	static boost::atomic<unsigned int> _connectionEpoch;
+};
+
+/**
+ * Computes content keys of data types with a Persistence trait.
+ */
+template <bool Enabled, typename DataType>
+struct ContentKeyDispatch {
+
+	static boost::uint64_t compute(DataType&) { return 0; }
+};
+
+template <typename DataType>
+struct ContentKeyDispatch<true, DataType> {
+
+	static boost::uint64_t compute(DataType& data) {
+
+		ContentHash hash;
+		hash.add(Persistence<DataType>::hash(data));
+
+		data.setContentKey(hash.get());
+
+		return hash.get();
+	}
+};
+
+/**
+ * Creates the back buffers of double buffered outputs. By default, back 
+ * buffers are default constructed. Outputs that are updated incrementally can 
+ * ask for copies of the currently published data instead, see 
+ * OutputImpl::enableDoubleBuffering(). Specialize this class for data types 
+ * that can be created or copied cheaper.
+ */
+template <typename DataType>
+struct BufferFactory {
+
+	static DataType* create() {
+
+		return new DataType();
+	}
+
+	static DataType* copy(const DataType& front) {
+
+		return new DataType(front);
+	}
+};
+
+/**
+ * Wrapped types share the wrapped object on copy, therefore the wrapped object 
+ * has to be copied itself.
+ */
+template <typename T>
+struct BufferFactory<Wrap<T> > {
+
+	static Wrap<T>* create() {
+
+		return new Wrap<T>(boost::make_shared<T>());
+	}
+
+	static Wrap<T>* copy(const Wrap<T>& front) {
+
+		if (front.get())
+			return new Wrap<T>(boost::make_shared<T>(*front.get()));
+
+		return create();
+	}
 };
 
 template <typename DataType>
@@ -197,11 +379,11 @@ public:
 	/**
 	 * Default constructor.
 	 */
-	OutputImpl() {}
+	OutputImpl() : _createBackBuffer(0), _writing(false) {}
 
-	OutputImpl(DataType* data) : _data(data) {}
+	OutputImpl(DataType* data) : _data(data), _createBackBuffer(0), _writing(false) {}
 
-	OutputImpl(boost::shared_ptr<DataType> data) : _data(data) {}
+	OutputImpl(boost::shared_ptr<DataType> data) : _data(data), _createBackBuffer(0), _writing(false) {}
 
 	/**
 	 * Set the data of this output. The lifetime of the given object will be 
@@ -209,18 +391,22 @@ public:
 	 */
 	OutputImpl& operator=(DataType* data) {
 
-		_data = boost::shared_ptr<DataType>(data);
-		notifyPointerSet();
-
-		return *this;
+		return operator=(boost::shared_ptr<DataType>(data));
 	}
 
 	/**
-	 * Set the data of this output.
+	 * Set the data of this output. While a back buffer is in use, the data 
+	 * replaces the back buffer and will be published with it.
 	 */
 	OutputImpl& operator=(boost::shared_ptr<DataType> data) {
 
-		_data = data;
+		if (_writing) {
+
+			_back = data;
+			return *this;
+		}
+
+		boost::atomic_store(&_data, data);
 		notifyPointerSet();
 
 		return *this;
@@ -232,7 +418,10 @@ public:
 	 */
 	void reset() {
 
-		_data.reset();
+		if (_writing)
+			_back.reset();
+		else
+			boost::atomic_store(&_data, boost::shared_ptr<DataType>());
 	}
 
 	/**
@@ -240,7 +429,7 @@ public:
 	 */
 	DataType* get() const {
 
-		return _data.get();
+		return current().get();
 	}
 
 	/**
@@ -249,11 +438,11 @@ public:
 	DataType* operator->() const {
 
 #ifndef NDEBUG
-		if (!_data)
+		if (!current())
 			UTIL_THROW_EXCEPTION(NullPointer, "This output does not point to valid data");
 #endif
 
-		return _data.operator->();
+		return current().operator->();
 	}
 
 	/**
@@ -262,11 +451,11 @@ public:
 	DataType& operator*() const {
 
 #ifndef NDEBUG
-		if (!_data)
+		if (!current())
 			UTIL_THROW_EXCEPTION(NullPointer, "This output does not point to valid data");
 #endif
 
-		return *_data;
+		return *current();
 	}
 
 	/**
@@ -274,15 +463,36 @@ public:
 	 */
 	operator bool() const {
 
-		return static_cast<bool>(_data);
+		return static_cast<bool>(current());
 	}
 
 	/**
-	 * Get a shared pointer to the Data instance held by this output.
+	 * Get a shared pointer to the Data instance held by this output. For 
+	 * double buffered outputs, this is always the published data.
 	 */
 	boost::shared_ptr<Data> getSharedDataPointer() const {
 
-		return _data;
+		return boost::atomic_load(&_data);
+	}
+
+	/**
+	 * Set the Data instance held by this output.
+	 */
+	void setSharedDataPointer(boost::shared_ptr<Data> data) {
+
+		boost::shared_ptr<DataType> castedData = boost::dynamic_pointer_cast<DataType>(data);
+
+		if (data && !castedData)
+			UTIL_THROW_EXCEPTION(
+					AssignmentError,
+					"pointer of type " << typeName(*data) << " can not be assigned to output of type " << typeName(*this));
+
+		operator=(castedData);
+	}
+
+	void releaseData() {
+
+		reset();
 	}
 
 	/**
@@ -291,12 +501,114 @@ public:
 	 */
 	boost::shared_ptr<DataType> getSharedPointer() const {
 
-		return _data;
+		return current();
+	}
+
+	/**
+	 * Get a shared pointer to the concrete data type object published by 
+	 * this output. In contrast to getSharedPointer(), this never returns the 
+	 * back buffer of a double buffered output.
+	 */
+	boost::shared_ptr<DataType> getPublishedPointer() const {
+
+		return boost::atomic_load(&_data);
+	}
+
+	/**
+	 * Enable double buffering for this output. If the owning process node uses 
+	 * the DoubleBufferedLockingStrategy, updateOutputs() will write into a 
+	 * back buffer created by BufferFactory<DataType>, which gets published 
+	 * with a single pointer swap afterwards. Readers of the published data 
+	 * never have to wait for the writer.
+	 *
+	 * @param copyFront If true, each back buffer starts as a copy of the 
+	 *                  published data, for process nodes that update their 
+	 *                  outputs incrementally. Otherwise (the default), back 
+	 *                  buffers are default constructed, and updateOutputs() 
+	 *                  has to write the whole output.
+	 */
+	void enableDoubleBuffering(bool copyFront = false) {
+
+		_createBackBuffer = (copyFront ? &OutputImpl::copyBackBuffer : &OutputImpl::createBackBuffer);
+	}
+
+	bool isDoubleBuffered() const {
+
+		return _createBackBuffer != 0;
+	}
+
+	void beginBackBuffer() {
+
+		boost::shared_ptr<DataType> front = boost::atomic_load(&_data);
+
+		_back = boost::shared_ptr<DataType>(_createBackBuffer(front.get()));
+		_writing = true;
+	}
+
+	void publishBackBuffer() {
+
+		boost::shared_ptr<DataType> back;
+		back.swap(_back);
+
+		_writing = false;
+
+		// readers that still hold the previous data keep it alive
+		boost::atomic_store(&_data, back);
+		notifyPointerSet();
+	}
+
+	void discardBackBuffer() {
+
+		_back.reset();
+		_writing = false;
+	}
+
+	boost::uint64_t getContentKey(Data& data) const {
+
+		boost::uint64_t key = data.getContentKey();
+
+		if (key != 0)
+			return key;
+
+		DataType* typedData = dynamic_cast<DataType*>(&data);
+
+		if (!typedData)
+			return 0;
+
+		return ContentKeyDispatch<Persistence<DataType>::enabled, DataType>::compute(*typedData);
 	}
 
 private:
 
+	// the data as seen by the owning process node
+	const boost::shared_ptr<DataType>& current() const {
+
+		return (_writing ? _back : _data);
+	}
+
+	// the published data
 	boost::shared_ptr<DataType> _data;
+
+	// the data currently written by the owning process node, if double 
+	// buffered
+	boost::shared_ptr<DataType> _back;
+
+	static DataType* createBackBuffer(const DataType*) {
+
+		return BufferFactory<DataType>::create();
+	}
+
+	static DataType* copyBackBuffer(const DataType* front) {
+
+		return (front ? BufferFactory<DataType>::copy(*front) : BufferFactory<DataType>::create());
+	}
+
+	// creates back buffers, set if double buffering is enabled
+	DataType* (*_createBackBuffer)(const DataType*);
+
+	// true between beginBackBuffer() and publishing or discarding the back 
+	// buffer
+	bool _writing;
 };
 
 template <bool, typename T>
@@ -318,6 +630,30 @@ public:
 
 	OutputTypeDispatch(boost::shared_ptr<T> data) : parent_type(data) {}
 
+	/**
+	 * Get a data object from the pool of recycled objects of type T. The 
+	 * object is returned to the pool as soon as it is not referenced anymore, 
+	 * if it was assigned to this output, this is the case after all inputs 
+	 * dropped it. Objects are handed out with their previous content, the 
+	 * caller has to reinitialize them.
+	 *
+	 * Usage example:
+	 *
+	 *   boost::shared_ptr<Image> image = _output.acquire();
+	 *   image->resize(width, height);
+	 *   ...
+	 *   _output = image;
+	 */
+	boost::shared_ptr<T> acquire() {
+
+		boost::shared_ptr<T> data = DataPool<T>::acquire();
+
+		// recycled data has to look modified
+		data->touch();
+
+		return data;
+	}
+
 	using parent_type::operator=;
 };
 
@@ -344,8 +680,7 @@ public:
 	 */
 	OutputTypeDispatch& operator=(T* data) {
 
-		parent_type::operator=(new Wrap<T>(boost::shared_ptr<T>(data)));
-		return *this;
+		return operator=(boost::shared_ptr<T>(data));
 	}
 
 	/**
@@ -353,10 +688,21 @@ public:
 	 */
 	OutputTypeDispatch& operator=(boost::shared_ptr<T> data) {
 
-		parent_type::operator=(new Wrap<T>(data));
+		// the wrapper and its control block are allocated at once from a 
+		// memory pool
+		parent_type::operator=(boost::allocate_shared<Wrap<T> >(boost::fast_pool_allocator<Wrap<T> >(), data));
 		return *this;
 	}
 
+	/**
+	 * Get an object from the pool of recycled objects of type T. See 
+	 * OutputTypeDispatch<true, T>::acquire().
+	 */
+	boost::shared_ptr<T> acquire() {
+
+		return DataPool<T>::acquire();
+	}
+
 	/**
 	 * Get the data held by this output.
 	 */
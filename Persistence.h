@@ -0,0 +1,110 @@
+#ifndef PIPELINE_PERSISTENCE_H__
+#define PIPELINE_PERSISTENCE_H__
+
+#include <cstddef>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Wrap.h"
+
+namespace pipeline {
+
+/**
+ * Serialization trait for the persistent output cache. Specialize it for each
+ * type that should be stored across process runs:
+ *
+ * <code>
+ * template <>
+ * struct Persistence<Histogram> {
+ *
+ *   static const bool enabled = true;
+ *
+ *   // the number of bytes needed to store the histogram
+ *   static std::size_t size(const Histogram& histogram);
+ *
+ *   // write the histogram into a buffer of size() bytes
+ *   static void write(const Histogram& histogram, char* buffer);
+ *
+ *   // create a histogram that uses the buffer directly, the mapping has to 
+ *   // be kept alive as long as the histogram exists
+ *   static boost::shared_ptr<Histogram> view(const char* buffer, std::size_t size, boost::shared_ptr<const void> mapping);
+ *
+ *   // a hash of the content that is the same in every process run
+ *   static boost::uint64_t hash(const Histogram& histogram);
+ * };
+ * </code>
+ *
+ * For types that are only used as inputs of persistent process nodes, it is
+ * sufficient to implement hash().
+ */
+template <typename T>
+struct Persistence {
+
+	static const bool enabled = false;
+};
+
+/**
+ * Wrapped types are hashed by their content.
+ */
+template <typename T>
+struct Persistence<Wrap<T> > {
+
+	static const bool enabled = Persistence<T>::enabled;
+
+	static boost::uint64_t hash(const Wrap<T>& wrap) {
+
+		return Persistence<T>::hash(*wrap.get());
+	}
+};
+
+/**
+ * Incremental 64 bit FNV-1a hash, used to create content keys.
+ */
+class ContentHash {
+
+public:
+
+	ContentHash() :
+		_hash(14695981039346656037ULL) {}
+
+	void add(const void* data, std::size_t size) {
+
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+		for (std::size_t i = 0; i < size; i++) {
+
+			_hash ^= bytes[i];
+			_hash *= 1099511628211ULL;
+		}
+	}
+
+	void add(boost::uint64_t value) {
+
+		add(&value, sizeof(value));
+	}
+
+	void add(const std::string& value) {
+
+		add(value.data(), value.size());
+	}
+
+	/**
+	 * Get the hash of everything added so far. Never returns 0, which denotes 
+	 * unknown content.
+	 */
+	boost::uint64_t get() const {
+
+		return (_hash == 0 ? 1 : _hash);
+	}
+
+private:
+
+	boost::uint64_t _hash;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_PERSISTENCE_H__
+
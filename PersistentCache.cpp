@@ -0,0 +1,166 @@
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <unistd.h>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/make_shared.hpp>
+
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include "Logging.h"
+#include "PersistentCache.h"
+
+logger::LogChannel persistentcachelog("persistentcachelog", "[PersistentCache] ");
+
+namespace pipeline {
+
+util::ProgramOption optionPersistentCache(
+		util::_module           = "pipeline",
+		util::_long_name        = "persistentCache",
+		util::_description_text = "An existing directory to store the outputs of process nodes with persistent outputs "
+		                          "across program runs.");
+
+namespace {
+
+std::string cacheDirectory() {
+
+	static std::string directory = optionPersistentCache.as<std::string>();
+
+	return directory;
+}
+
+} // anonymous namespace
+
+bool
+PersistentCache::isEnabled() {
+
+	static bool enabled = !cacheDirectory().empty();
+
+	return enabled;
+}
+
+PersistentCache&
+PersistentCache::getInstance() {
+
+	static PersistentCache instance(cacheDirectory());
+
+	return instance;
+}
+
+PersistentCache::PersistentCache(const std::string& directory) :
+	_directory(directory) {}
+
+bool
+PersistentCache::load(boost::uint64_t key, unsigned int num, boost::shared_ptr<const void>& mapping, const char*& buffer, std::size_t& size) {
+
+	std::string filename = getFilename(key, num);
+
+	// mapping an empty file fails, check the size first
+	std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+
+	if (!file)
+		return false;
+
+	size = file.tellg();
+	file.close();
+
+	if (size == 0) {
+
+		mapping.reset();
+		buffer = 0;
+
+		return true;
+	}
+
+	try {
+
+		boost::interprocess::file_mapping fileMapping(filename.c_str(), boost::interprocess::read_only);
+
+		boost::shared_ptr<boost::interprocess::mapped_region> region =
+				boost::make_shared<boost::interprocess::mapped_region>(fileMapping, boost::interprocess::read_only);
+
+		mapping = region;
+		buffer  = static_cast<const char*>(region->get_address());
+		size    = region->get_size();
+
+	} catch (boost::interprocess::interprocess_exception& e) {
+
+		LOG_ERROR(persistentcachelog) << "can not map " << filename << ": " << e.what() << std::endl;
+		return false;
+	}
+
+	PIPELINE_LOG_ALL(persistentcachelog) << "mapped " << filename << " (" << size << " bytes)" << std::endl;
+
+	return true;
+}
+
+void
+PersistentCache::store(boost::uint64_t key, unsigned int num, std::size_t size, boost::function<void(char*)> write) {
+
+	std::string filename = getFilename(key, num);
+
+	std::ostringstream temporary;
+	temporary << filename << ".tmp" << getpid();
+
+	try {
+
+		{
+			std::ofstream file(temporary.str().c_str(), std::ios::binary | std::ios::trunc);
+
+			if (!file) {
+
+				LOG_ERROR(persistentcachelog) << "can not create " << temporary.str() << std::endl;
+				return;
+			}
+
+			// allocate the file
+			if (size > 0) {
+
+				file.seekp(size - 1);
+				file.put(0);
+			}
+		}
+
+		// write directly into the mapped file
+		if (size > 0) {
+
+			boost::interprocess::file_mapping fileMapping(temporary.str().c_str(), boost::interprocess::read_write);
+			boost::interprocess::mapped_region region(fileMapping, boost::interprocess::read_write);
+
+			write(static_cast<char*>(region.get_address()));
+
+			region.flush();
+		}
+
+	} catch (boost::interprocess::interprocess_exception& e) {
+
+		LOG_ERROR(persistentcachelog) << "can not write " << temporary.str() << ": " << e.what() << std::endl;
+		std::remove(temporary.str().c_str());
+		return;
+	}
+
+	if (std::rename(temporary.str().c_str(), filename.c_str()) != 0) {
+
+		LOG_ERROR(persistentcachelog) << "can not rename " << temporary.str() << " to " << filename << std::endl;
+		std::remove(temporary.str().c_str());
+		return;
+	}
+
+	PIPELINE_LOG_ALL(persistentcachelog) << "stored " << filename << " (" << size << " bytes)" << std::endl;
+}
+
+std::string
+PersistentCache::getFilename(boost::uint64_t key, unsigned int num) {
+
+	std::ostringstream filename;
+
+	filename << _directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << "_" << std::dec << num;
+
+	return filename.str();
+}
+
+} // namespace pipeline
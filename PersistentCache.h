@@ -0,0 +1,123 @@
+#ifndef PIPELINE_PERSISTENT_CACHE_H__
+#define PIPELINE_PERSISTENT_CACHE_H__
+
+#include <cstddef>
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Output.h"
+#include "Persistence.h"
+
+namespace pipeline {
+
+/**
+ * File store of output data that persists across process runs. Each entry is 
+ * a file in the directory given by the program option 'persistentCache', 
+ * named after the content key of the process node and the number of the 
+ * output. Entries are memory-mapped when loaded, such that types with a 
+ * Persistence trait can be used directly from the mapping.
+ *
+ * Entries are written to a temporary file first and renamed afterwards, 
+ * therefore several processes can share a cache directory.
+ */
+class PersistentCache {
+
+public:
+
+	/**
+	 * Returns true, if the program option 'persistentCache' was set.
+	 */
+	static bool isEnabled();
+
+	static PersistentCache& getInstance();
+
+	/**
+	 * Map an entry of the cache.
+	 *
+	 * @param key     The content key of the process node.
+	 * @param num     The number of the output.
+	 * @param mapping [out] Keeps the mapping alive.
+	 * @param buffer  [out] The content of the entry.
+	 * @param size    [out] The size of the entry in bytes.
+	 * @return false, if there is no such entry.
+	 */
+	bool load(boost::uint64_t key, unsigned int num, boost::shared_ptr<const void>& mapping, const char*& buffer, std::size_t& size);
+
+	/**
+	 * Store an entry in the cache.
+	 *
+	 * @param key   The content key of the process node.
+	 * @param num   The number of the output.
+	 * @param size  The size of the entry in bytes.
+	 * @param write Writes the content into a buffer of the given size.
+	 */
+	void store(boost::uint64_t key, unsigned int num, std::size_t size, boost::function<void(char*)> write);
+
+private:
+
+	PersistentCache(const std::string& directory);
+
+	std::string getFilename(boost::uint64_t key, unsigned int num);
+
+	std::string _directory;
+};
+
+/**
+ * Loads and stores one output of a process node with the PersistentCache.
+ */
+class PersistentOutputBase {
+
+public:
+
+	virtual ~PersistentOutputBase() {}
+
+	/**
+	 * Set the output to the data of a cache entry.
+	 */
+	virtual void assign(const char* buffer, std::size_t size, boost::shared_ptr<const void> mapping) = 0;
+
+	/**
+	 * Store the current data of the output in the cache.
+	 */
+	virtual void store(boost::uint64_t key, unsigned int num) = 0;
+};
+
+template <typename T>
+class PersistentOutput : public PersistentOutputBase {
+
+public:
+
+	PersistentOutput(Output<T>& output) :
+		_output(output) {}
+
+	void assign(const char* buffer, std::size_t size, boost::shared_ptr<const void> mapping) {
+
+		_output = Persistence<T>::view(buffer, size, mapping);
+	}
+
+	void store(boost::uint64_t key, unsigned int num) {
+
+		T* data = _output.get();
+
+		if (!data)
+			return;
+
+		PersistentCache::getInstance().store(
+				key,
+				num,
+				Persistence<T>::size(*data),
+				boost::bind(&Persistence<T>::write, boost::cref(*data), _1));
+	}
+
+private:
+
+	Output<T>& _output;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_PERSISTENT_CACHE_H__
+
@@ -0,0 +1,84 @@
+#ifndef PIPELINE_PORTS_H__
+#define PIPELINE_PORTS_H__
+
+#include "FlatInputs.h"
+#include "Input.h"
+#include "Inputs.h"
+#include "Output.h"
+
+namespace pipeline {
+
+/**
+ * Compile-time declarations of the inputs, multi-inputs, and outputs of a
+ * process node. A port binds the data type of an input or output to its
+ * number. Process nodes that declare their ports can be connected and
+ * addressed without name look-ups and without runtime type checks, see
+ * SimpleProcessNode.
+ *
+ * Example usage:
+ * <code>
+ * class Threshold : public SimpleProcessNode<> {
+ *
+ * public:
+ *
+ *   typedef InputPort<Image, 0>  ImageIn;
+ *   typedef InputPort<float, 1>  ThresholdIn;
+ *   typedef OutputPort<Image, 0> MaskOut;
+ *
+ *   Threshold() {
+ *
+ *     registerInput<ImageIn>(_image, "image");
+ *     registerInput<ThresholdIn>(_threshold, "threshold");
+ *     registerOutput<MaskOut>(_mask, "mask");
+ *   }
+ *
+ *   ...
+ * };
+ *
+ * // the data types are verified when compiling
+ * threshold->setInput<Threshold::ImageIn>(reader->getOutput<Reader::ImageOut>());
+ * </code>
+ *
+ * Ports have to be registered in the order of their numbers, starting with 0
+ * for each kind of port.
+ */
+template <typename DataType, unsigned int Number>
+struct InputPort {
+
+	typedef DataType        data_type;
+	typedef Input<DataType> port_type;
+
+	static const unsigned int number = Number;
+};
+
+template <typename DataType, unsigned int Number>
+struct InputsPort {
+
+	typedef DataType         data_type;
+	typedef Inputs<DataType> port_type;
+
+	static const unsigned int number = Number;
+};
+
+template <typename DataType, unsigned int Number>
+struct FlatInputsPort {
+
+	typedef DataType             data_type;
+	typedef FlatInputs<DataType> port_type;
+
+	static const unsigned int number = Number;
+};
+
+template <typename DataType, unsigned int Number>
+struct OutputPort {
+
+	typedef DataType         data_type;
+	typedef Output<DataType> port_type;
+
+	static const unsigned int number = Number;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_PORTS_H__
+
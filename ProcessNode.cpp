@@ -1,8 +1,16 @@
+#include <set>
+
+#include <boost/make_shared.hpp>
+
 #include "ProcessNode.h"
 #include <util/exceptions.h>
+#include <util/foreach.h>
 
 namespace pipeline {
 
+ProcessNode::ProcessNode() :
+	_ports(boost::make_shared<Ports>()) {}
+
 bool
 ProcessNode::setInput(OutputBase& output) {
 
@@ -156,14 +164,16 @@ ProcessNode::getOutput() {
 OutputBase&
 ProcessNode::getOutput(unsigned int i) {
 
-	if (_outputs.size() <= i) {
+	boost::shared_ptr<const Ports> ports = getPorts();
+
+	if (ports->outputs.size() <= i) {
 
 		UTIL_THROW_EXCEPTION(
 				NotEnoughOutputs,
-				"invalid output number " << i << ", this process node has only " << _outputs.size() << " outputs");
+				"invalid output number " << i << ", this process node has only " << ports->outputs.size() << " outputs");
 	}
 
-	return *_outputs[i];
+	return *ports->outputs[i];
 }
 
 OutputBase&
@@ -171,7 +181,11 @@ ProcessNode::getOutput(std::string name) {
 
 	PIPELINE_LOG_ALL(pipelinelog) << "[ProcessNode] searching for output with name " << name << std::endl;
 
-	if (!_outputNames.count(name)) {
+	boost::shared_ptr<const Ports> ports = getPorts();
+
+	std::map<std::string, OutputBase*>::const_iterator output = ports->outputNames.find(name);
+
+	if (output == ports->outputNames.end()) {
 
 		UTIL_THROW_EXCEPTION(
 				NoSuchOutput,
@@ -179,7 +193,7 @@ ProcessNode::getOutput(std::string name) {
 
 	} else {
 
-		return *_outputNames[name];
+		return *output->second;
 	}
 }
 
@@ -192,17 +206,29 @@ ProcessNode::getSelfSharedPointer() {
 void
 ProcessNode::registerInput(InputBase& input, std::string name) {
 
-	_inputs.push_back(&input);
+	boost::mutex::scoped_lock lock(_portsMutex);
+
+	boost::shared_ptr<Ports> ports = copyPorts();
+
+	ports->inputs.push_back(&input);
 
-	_inputNames[name] = &input;
+	ports->inputNames[name] = &input;
+
+	boost::atomic_store(&_ports, boost::shared_ptr<const Ports>(ports));
 }
 
 void
 ProcessNode::registerInputs(MultiInput& input, std::string name) {
 
-	_multiInputs.push_back(&input);
+	boost::mutex::scoped_lock lock(_portsMutex);
+
+	boost::shared_ptr<Ports> ports = copyPorts();
 
-	_multiInputNames[name] = &input;
+	ports->multiInputs.push_back(&input);
+
+	ports->multiInputNames[name] = &input;
+
+	boost::atomic_store(&_ports, boost::shared_ptr<const Ports>(ports));
 }
 
 void
@@ -210,9 +236,27 @@ ProcessNode::registerOutput(OutputBase& output, std::string name) {
 
 	output.addDependency(this);
 
-	_outputs.push_back(&output);
+	boost::mutex::scoped_lock lock(_portsMutex);
+
+	boost::shared_ptr<Ports> ports = copyPorts();
+
+	ports->outputs.push_back(&output);
+
+	ports->outputNames[name] = &output;
+
+	boost::atomic_store(&_ports, boost::shared_ptr<const Ports>(ports));
+}
+
+boost::shared_ptr<const ProcessNode::Ports>
+ProcessNode::getPorts() const {
+
+	return boost::atomic_load(&_ports);
+}
+
+boost::shared_ptr<ProcessNode::Ports>
+ProcessNode::copyPorts() const {
 
-	_outputNames[name] = &output;
+	return boost::make_shared<Ports>(*_ports);
 }
 
 InputBase&
@@ -224,18 +268,24 @@ ProcessNode::getInput() {
 InputBase&
 ProcessNode::getInput(unsigned int i) {
 
-	if (_inputs.size() <= i)
+	boost::shared_ptr<const Ports> ports = getPorts();
+
+	if (ports->inputs.size() <= i)
 		UTIL_THROW_EXCEPTION(
 				NotEnoughInputs,
-				"invalid input number " << i << ", this process node has only " << _inputs.size() << " inputs");
+				"invalid input number " << i << ", this process node has only " << ports->inputs.size() << " inputs");
 
-	return *_inputs[i];
+	return *ports->inputs[i];
 }
 
 InputBase&
 ProcessNode::getInput(std::string name) {
 
-	if (!_inputNames.count(name)) {
+	boost::shared_ptr<const Ports> ports = getPorts();
+
+	std::map<std::string, InputBase*>::const_iterator input = ports->inputNames.find(name);
+
+	if (input == ports->inputNames.end()) {
 
 		UTIL_THROW_EXCEPTION(
 				NoSuchInput,
@@ -243,10 +293,44 @@ ProcessNode::getInput(std::string name) {
 
 	} else {
 
-		return *_inputNames[name];
+		return *input->second;
 	}
 }
 
+std::vector<boost::shared_ptr<ProcessNode> >
+ProcessNode::getUpstreamProcessNodes() {
+
+	boost::shared_ptr<const Ports> ports = getPorts();
+
+	std::vector<OutputBase*> outputs;
+
+	foreach (InputBase* input, ports->inputs)
+		if (input->hasAssignedOutput())
+			outputs.push_back(&input->getAssignedOutput());
+
+	foreach (MultiInput* multiInput, ports->multiInputs)
+		for (unsigned int i = 0; i < multiInput->size(); i++)
+			if (multiInput->getAssignedOutput(i))
+				outputs.push_back(multiInput->getAssignedOutput(i));
+
+	std::set<ProcessNode*> seen;
+	std::vector<boost::shared_ptr<ProcessNode> > upstream;
+
+	foreach (OutputBase* output, outputs)
+		foreach (boost::shared_ptr<ProcessNode> processNode, output->getDependencies())
+			if (seen.insert(processNode.get()).second)
+				upstream.push_back(processNode);
+
+	return upstream;
+}
+
+void
+ProcessNode::updateScheduledBatch(const std::vector<ProcessNode*>& processNodes) {
+
+	foreach (ProcessNode* processNode, processNodes)
+		processNode->updateScheduled();
+}
+
 MultiInput&
 ProcessNode::getMultiInput() {
 
@@ -256,18 +340,24 @@ ProcessNode::getMultiInput() {
 MultiInput&
 ProcessNode::getMultiInput(unsigned int i) {
 
-	if (_multiInputs.size() <= i)
+	boost::shared_ptr<const Ports> ports = getPorts();
+
+	if (ports->multiInputs.size() <= i)
 		UTIL_THROW_EXCEPTION(
 				NotEnoughInputs,
-				"invalid multi-input number " << i << ", this process node has only " << _multiInputs.size() << " multi-inputs");
+				"invalid multi-input number " << i << ", this process node has only " << ports->multiInputs.size() << " multi-inputs");
 
-	return *_multiInputs[i];
+	return *ports->multiInputs[i];
 }
 
 MultiInput&
 ProcessNode::getMultiInput(std::string name) {
 
-	if (!_multiInputNames.count(name)) {
+	boost::shared_ptr<const Ports> ports = getPorts();
+
+	std::map<std::string, MultiInput*>::const_iterator multiInput = ports->multiInputNames.find(name);
+
+	if (multiInput == ports->multiInputNames.end()) {
 
 		UTIL_THROW_EXCEPTION(
 				NoSuchInput,
@@ -275,7 +365,7 @@ ProcessNode::getMultiInput(std::string name) {
 
 	} else {
 
-		return *_multiInputNames[name];
+		return *multiInput->second;
 	}
 }
 
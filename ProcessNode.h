@@ -1,13 +1,16 @@
 #ifndef PROCESS_NODE_H__
 #define PROCESS_NODE_H__
 
+#include <boost/cstdint.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "exceptions.h"
 #include "Input.h"
 #include "Inputs.h"
 #include "Output.h"
 #include "Logging.h"
+#include "signals/Update.h"
 
 namespace pipeline {
 
@@ -20,6 +23,8 @@ public:
 	struct NotEnoughOutputs : virtual PipelineError, virtual SizeMismatchError {};
 	struct NoSuchOutput     : virtual PipelineError {};
 
+	ProcessNode();
+
 	/**
 	 * Assign the first input of this process node to the given output. A call
 	 * to this function is equivalent to setInput(0, output).
@@ -246,8 +251,119 @@ public:
 	 */
 	InputBase& getInput(std::string name);
 
+	/**
+	 * Get all process nodes that are connected to the inputs or multi-inputs
+	 * of this process node.
+	 *
+	 * @return Shared pointers to the upstream process nodes (without 
+	 *         duplicates).
+	 */
+	std::vector<boost::shared_ptr<ProcessNode> > getUpstreamProcessNodes();
+
 protected:
 
+	// the UpdateScheduler calls the update interface below
+	friend class UpdateScheduler;
+
+	/**
+	 * Part of the update interface used by the UpdateScheduler. Should return 
+	 * true, if this process node has to recompute its outputs. Process nodes 
+	 * that return false are considered to be up-to-date, together with all 
+	 * process nodes upstream of them.
+	 */
+	virtual bool needsUpdate() { return false; }
+
+	/**
+	 * Part of the update interface used by the UpdateScheduler. Recompute all 
+	 * outputs of this process node. This will only be called after all dirty 
+	 * upstream process nodes have been updated.
+	 */
+	virtual void updateScheduled() {}
+
+	/**
+	 * Part of the update interface used by the UpdateScheduler. Should return 
+	 * true, if this process node can be updated together with other ready 
+	 * process nodes of the same type by a single call to 
+	 * updateScheduledBatch().
+	 */
+	virtual bool isBatchable() { return false; }
+
+	/**
+	 * Part of the update interface used by the UpdateScheduler. Recompute all 
+	 * outputs of the given process nodes, which are batchable, of the same 
+	 * type as this process node, and independent of each other. The default 
+	 * implementation calls updateScheduled() on each of them.
+	 */
+	virtual void updateScheduledBatch(const std::vector<ProcessNode*>& processNodes);
+
+	/**
+	 * Part of the update interface used by the UpdateScheduler. Get the 
+	 * expected time in nanoseconds to recompute the outputs of this process 
+	 * node, or 0 if it is not known. Used to find the critical path of the 
+	 * graph.
+	 */
+	virtual boost::uint64_t getEstimatedCost() { return 0; }
+
+	// SimpleProcessNodes call the dispatch interface below of their upstream 
+	// process nodes
+	template <typename LockingStrategy>
+	friend class SimpleProcessNode;
+
+	/**
+	 * Part of the compiled signal dispatch of SimpleProcessNode. Get the 
+	 * number of the given output, if Update signals to this output can be 
+	 * replaced by calls to updateDirectly().
+	 *
+	 * @return The number of the output, or -1 if a signal has to be sent.
+	 */
+	virtual int getDirectUpdateOutput(OutputBase& /*output*/) { return -1; }
+
+	/**
+	 * Part of the compiled signal dispatch of SimpleProcessNode. Handle an 
+	 * Update signal for an output, as if it was received via the signal 
+	 * library.
+	 */
+	virtual void updateDirectly(const Update& /*signal*/, int /*numOutput*/) {}
+
+	/**
+	 * Part of the chain fusion of SimpleProcessNode. Returns true, if this 
+	 * process node can be a link of a fused chain, i.e., if it has a single 
+	 * input and a single output.
+	 */
+	virtual bool isFusible() { return false; }
+
+	/**
+	 * Part of the chain fusion of SimpleProcessNode. Get the process node 
+	 * upstream of the single input of this process node, if it can be updated 
+	 * by direct calls and this process node is the only consumer of its 
+	 * output.
+	 */
+	virtual boost::shared_ptr<ProcessNode> getFusedUpstream() { return boost::shared_ptr<ProcessNode>(); }
+
+	/**
+	 * Part of the chain fusion of SimpleProcessNode. Test and clear the dirty 
+	 * flag of the single input. Called without the update mutex of this 
+	 * process node, therefore the outputs are set dirty first.
+	 *
+	 * @return True, if the input was dirty.
+	 */
+	virtual bool clearFusedInput() { return false; }
+
+	/**
+	 * Part of the chain fusion of SimpleProcessNode. Set the single input 
+	 * dirty again, after a fused update failed.
+	 */
+	virtual void setFusedInputDirty() {}
+
+	/**
+	 * Part of the chain fusion of SimpleProcessNode. Handle an Update signal 
+	 * for the single output, assuming that the input is up-to-date.
+	 *
+	 * @param inputModified True, if the input was modified since the last 
+	 *                      update, i.e., if clearFusedInput() returned true.
+	 */
+	virtual void updateFused(bool /*inputModified*/) {}
+
 	/**
 	 * Register an input with this process node.
 	 *
@@ -272,21 +388,45 @@ protected:
 	 */
 	void registerOutput(OutputBase& output, std::string name);
 
+	/**
+	 * Get a multi-input of this process node by its number.
+	 *
+	 * @param i The number of the multi-input.
+	 */
+	MultiInput& getMultiInput(unsigned int i);
+
 private:
 
 	MultiInput& getMultiInput();
 
-	MultiInput& getMultiInput(unsigned int i);
-
 	MultiInput& getMultiInput(std::string name);
 
-	std::vector<InputBase*>  _inputs;
-	std::vector<MultiInput*> _multiInputs;
-	std::vector<OutputBase*> _outputs;
+	// the registered inputs, multi-inputs, and outputs, never changed after 
+	// they have been published
+	struct Ports {
+
+		std::vector<InputBase*>  inputs;
+		std::vector<MultiInput*> multiInputs;
+		std::vector<OutputBase*> outputs;
+
+		std::map<std::string, OutputBase*> outputNames;
+		std::map<std::string, InputBase*>  inputNames;
+		std::map<std::string, MultiInput*> multiInputNames;
+	};
+
+	// get the current ports
+	boost::shared_ptr<const Ports> getPorts() const;
+
+	// get a copy of the current ports to register a new one, assumes that 
+	// _portsMutex is locked
+	boost::shared_ptr<Ports> copyPorts() const;
+
+	// the current ports, replaced atomically (written under _portsMutex), such 
+	// that ports can be looked up while others are registered
+	boost::shared_ptr<const Ports> _ports;
 
-	std::map<std::string, OutputBase*> _outputNames;
-	std::map<std::string, InputBase*>  _inputNames;
-	std::map<std::string, MultiInput*> _multiInputNames;
+	// serializes the registration of ports
+	boost::mutex _portsMutex;
 };
 
 } // namespace pipeline
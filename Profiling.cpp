@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include <boost/chrono.hpp>
+#include <boost/thread/once.hpp>
+
+#include <util/foreach.h>
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include "Profiling.h"
+
+logger::LogChannel profilinglog("profilinglog", "[Profiler] ");
+
+namespace pipeline {
+
+util::ProgramOption optionProfile(
+		util::_module           = "pipeline",
+		util::_long_name        = "profile",
+		util::_description_text = "Collect update statistics for each process node and print them at program exit.");
+
+util::ProgramOption optionTraceFile(
+		util::_module           = "pipeline",
+		util::_long_name        = "traceFile",
+		util::_description_text = "Record the updates of all process nodes and write them to the given file at program "
+		                          "exit (Chrome trace event format).");
+
+namespace {
+
+Profiler*        globalProfiler = 0;
+boost::once_flag globalProfilerFlag = BOOST_ONCE_INIT;
+
+// Defined before exitReport, such that it is destructed after the trace was 
+// written. A function-local static would be constructed on first use only, 
+// i.e., after exitReport, and destructed before it.
+std::string      traceFilename;
+boost::once_flag traceFilenameFlag = BOOST_ONCE_INIT;
+
+void readTraceFile() {
+
+	traceFilename = optionTraceFile.as<std::string>();
+}
+
+std::string traceFile() {
+
+	boost::call_once(traceFilenameFlag, &readTraceFile);
+
+	return traceFilename;
+}
+
+bool compareUpdateTime(boost::shared_ptr<const NodeStatistics> a, boost::shared_ptr<const NodeStatistics> b) {
+
+	return a->updateTime > b->updateTime;
+}
+
+// replace characters that are not allowed in JSON strings
+std::string escape(const std::string& s) {
+
+	std::string escaped;
+
+	foreach (char c, s) {
+
+		if (c == '"' || c == '\\')
+			escaped += '\\';
+
+		if (static_cast<unsigned char>(c) < 0x20)
+			escaped += ' ';
+		else
+			escaped += c;
+	}
+
+	return escaped;
+}
+
+/**
+ * Writes the collected statistics and traces at program exit.
+ */
+struct ExitReport {
+
+	~ExitReport() {
+
+		if (!globalProfiler)
+			return;
+
+		if (optionProfile) {
+
+			std::ostringstream table;
+			globalProfiler->printStatistics(table);
+
+			LOG_USER(profilinglog) << "update statistics:" << std::endl << table.str();
+		}
+
+		if (Profiler::isTracing())
+			globalProfiler->writeTrace(traceFile());
+	}
+
+} exitReport;
+
+} // anonymous namespace
+
+bool
+Profiler::isEnabled() {
+
+	static bool enabled = optionProfile || isTracing();
+
+	return enabled;
+}
+
+bool
+Profiler::isTracing() {
+
+	static bool tracing = !traceFile().empty();
+
+	return tracing;
+}
+
+Profiler&
+Profiler::getInstance() {
+
+	boost::call_once(globalProfilerFlag, &Profiler::createInstance);
+
+	return *globalProfiler;
+}
+
+void
+Profiler::createInstance() {
+
+	// Never destructed: Process nodes might report updates during static 
+	// destruction.
+	globalProfiler = new Profiler();
+}
+
+Profiler::time_type
+Profiler::now() {
+
+	return boost::chrono::duration_cast<boost::chrono::nanoseconds>(
+			boost::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::Profiler() :
+	_start(now()) {}
+
+boost::shared_ptr<NodeStatistics>
+Profiler::createStatistics(const std::string& name) {
+
+	boost::shared_ptr<NodeStatistics> statistics(new NodeStatistics(name));
+
+	boost::mutex::scoped_lock lock(_mutex);
+
+	_statistics.push_back(statistics);
+
+	return statistics;
+}
+
+std::vector<boost::shared_ptr<const NodeStatistics> >
+Profiler::getStatistics() {
+
+	boost::mutex::scoped_lock lock(_mutex);
+
+	return std::vector<boost::shared_ptr<const NodeStatistics> >(_statistics.begin(), _statistics.end());
+}
+
+void
+Profiler::printStatistics(std::ostream& out) {
+
+	std::vector<boost::shared_ptr<const NodeStatistics> > statistics = getStatistics();
+
+	std::sort(statistics.begin(), statistics.end(), &compareUpdateTime);
+
+	out << std::setw(40) << std::left << "process node"
+	    << std::setw(14) << std::right << "update [ms]"
+	    << std::setw(14) << "mutex [ms]"
+	    << std::setw(14) << "locks [ms]"
+	    << std::setw(10) << "updates"
+	    << std::setw(10) << "current"
+	    << std::setw(10) << "cached"
+	    << std::setw(10) << "parallel" << std::endl;
+
+	foreach (boost::shared_ptr<const NodeStatistics> s, statistics)
+		out << std::setw(40) << std::left << s->name
+		    << std::setw(14) << std::right << std::fixed << std::setprecision(3) << s->updateTime*1e-6
+		    << std::setw(14) << s->updateMutexWaitTime*1e-6
+		    << std::setw(14) << s->lockWaitTime*1e-6
+		    << std::setw(10) << s->numUpdates
+		    << std::setw(10) << s->numUpToDate
+		    << std::setw(10) << s->numCacheHits
+		    << std::setw(10) << s->numParallelUpdates << std::endl;
+}
+
+void
+Profiler::addTraceEvent(const std::string& name, time_type begin, time_type end) {
+
+	if (!isTracing())
+		return;
+
+	boost::mutex::scoped_lock lock(_mutex);
+
+	TraceEvent event;
+	event.name   = name;
+	event.begin  = begin;
+	event.end    = end;
+	event.thread = getThreadNumber();
+
+	_events.push_back(event);
+}
+
+void
+Profiler::writeTrace(const std::string& filename) {
+
+	std::ofstream out(filename.c_str());
+
+	if (!out) {
+
+		LOG_ERROR(profilinglog) << "can not open trace file " << filename << std::endl;
+		return;
+	}
+
+	boost::mutex::scoped_lock lock(_mutex);
+
+	out << "{\"traceEvents\":[" << std::endl;
+
+	for (unsigned int i = 0; i < _events.size(); i++) {
+
+		const TraceEvent& event = _events[i];
+
+		// times are given in microseconds
+		out << (i > 0 ? ",\n" : "")
+		    << "{\"name\":\"" << escape(event.name) << "\",\"cat\":\"update\",\"ph\":\"X\""
+		    << ",\"ts\":" << (event.begin - _start)/1000.0
+		    << ",\"dur\":" << (event.end - event.begin)/1000.0
+		    << ",\"pid\":0,\"tid\":" << event.thread << "}";
+	}
+
+	out << std::endl << "]}" << std::endl;
+
+	LOG_DEBUG(profilinglog) << "wrote " << _events.size() << " trace events to " << filename << std::endl;
+}
+
+unsigned int
+Profiler::getThreadNumber() {
+
+	boost::thread::id id = boost::this_thread::get_id();
+
+	std::map<boost::thread::id, unsigned int>::iterator i = _threadNumbers.find(id);
+
+	if (i != _threadNumbers.end())
+		return i->second;
+
+	unsigned int number = _threadNumbers.size();
+	_threadNumbers[id] = number;
+
+	return number;
+}
+
+} // namespace pipeline
@@ -0,0 +1,175 @@
+#ifndef PIPELINE_PROFILING_H__
+#define PIPELINE_PROFILING_H__
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace pipeline {
+
+/**
+ * Update statistics of a single process node. All times are in nanoseconds. 
+ * The counters are updated atomically and can be read at any time.
+ */
+struct NodeStatistics {
+
+	NodeStatistics(const std::string& name_) :
+		name(name_),
+		updateTime(0),
+		updateMutexWaitTime(0),
+		lockWaitTime(0),
+		numUpdates(0),
+		numUpToDate(0),
+		numCacheHits(0),
+		numParallelUpdates(0) {}
+
+	// the type and name of the process node
+	const std::string name;
+
+	// time spent in updateOutputs()
+	boost::atomic<boost::uint64_t> updateTime;
+
+	// time spent waiting for the update mutex
+	boost::atomic<boost::uint64_t> updateMutexWaitTime;
+
+	// time spent in the locking strategy before updateOutputs() was called
+	boost::atomic<boost::uint64_t> lockWaitTime;
+
+	// number of calls to updateOutputs()
+	boost::atomic<boost::uint64_t> numUpdates;
+
+	// number of update requests that found the outputs up-to-date
+	boost::atomic<boost::uint64_t> numUpToDate;
+
+	// number of updates that restored cached outputs
+	boost::atomic<boost::uint64_t> numCacheHits;
+
+	// number of input updates submitted to the thread pool
+	boost::atomic<boost::uint64_t> numParallelUpdates;
+};
+
+/**
+ * Process-wide registry of process node statistics and update traces. 
+ * Profiling is enabled with the program options 'profile' or 'traceFile'. If 
+ * a trace file is given, the updates of all process nodes are recorded and 
+ * written at program exit in the Chrome trace event format, which can be 
+ * viewed with chrome://tracing or Perfetto.
+ */
+class Profiler {
+
+public:
+
+	typedef boost::uint64_t time_type;
+
+	/**
+	 * Returns true, if statistics should be collected.
+	 */
+	static bool isEnabled();
+
+	/**
+	 * Returns true, if trace events should be recorded.
+	 */
+	static bool isTracing();
+
+	/**
+	 * Get the process-wide profiler.
+	 */
+	static Profiler& getInstance();
+
+	/**
+	 * Get the current time in nanoseconds, measured by a monotonic clock.
+	 */
+	static time_type now();
+
+	/**
+	 * Create statistics for a process node. The profiler keeps them after the 
+	 * process node was destructed.
+	 */
+	boost::shared_ptr<NodeStatistics> createStatistics(const std::string& name);
+
+	/**
+	 * Get the statistics of all process nodes that have been profiled so far.
+	 */
+	std::vector<boost::shared_ptr<const NodeStatistics> > getStatistics();
+
+	/**
+	 * Print a table of all statistics, ordered by the time spent in 
+	 * updateOutputs().
+	 */
+	void printStatistics(std::ostream& out);
+
+	/**
+	 * Record a trace event. Does nothing, if tracing is not enabled.
+	 *
+	 * @param name  The name of the event.
+	 * @param begin The start time as given by now().
+	 * @param end   The end time as given by now().
+	 */
+	void addTraceEvent(const std::string& name, time_type begin, time_type end);
+
+	/**
+	 * Write all recorded trace events to a file in the Chrome trace event 
+	 * format.
+	 */
+	void writeTrace(const std::string& filename);
+
+private:
+
+	struct TraceEvent {
+
+		std::string  name;
+		time_type    begin;
+		time_type    end;
+		unsigned int thread;
+	};
+
+	Profiler();
+
+	static void createInstance();
+
+	// get a small number identifying the calling thread
+	unsigned int getThreadNumber();
+
+	boost::mutex _mutex;
+
+	std::vector<boost::shared_ptr<NodeStatistics> > _statistics;
+
+	std::vector<TraceEvent> _events;
+
+	std::map<boost::thread::id, unsigned int> _threadNumbers;
+
+	// the time of the creation of the profiler, trace times are relative to 
+	// it
+	time_type _start;
+};
+
+/**
+ * Measures the time since its creation, if profiling is enabled.
+ */
+class ProfilingTimer {
+
+public:
+
+	ProfilingTimer() :
+		_start(Profiler::isEnabled() ? Profiler::now() : 0) {}
+
+	Profiler::time_type getStart() const { return _start; }
+
+	Profiler::time_type elapsed() const { return (_start ? Profiler::now() - _start : 0); }
+
+private:
+
+	Profiler::time_type _start;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_PROFILING_H__
+
@@ -0,0 +1,161 @@
+#ifndef PIPELINE_REGION_H__
+#define PIPELINE_REGION_H__
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace pipeline {
+
+/**
+ * An axis-aligned box in up to three dimensions, used to describe the part of 
+ * a data object that was modified or is requested. The bounds are inclusive. 
+ * Unused dimensions should span everything.
+ */
+class Region {
+
+public:
+
+	/**
+	 * Create an empty region.
+	 */
+	Region() :
+		_minX(1), _minY(1), _minZ(1),
+		_maxX(0), _maxY(0), _maxZ(0) {}
+
+	/**
+	 * Create a region from its inclusive bounds.
+	 */
+	Region(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) :
+		_minX(minX), _minY(minY), _minZ(minZ),
+		_maxX(maxX), _maxY(maxY), _maxZ(maxZ) {}
+
+	/**
+	 * Create a two-dimensional region that spans all z.
+	 */
+	Region(int minX, int minY, int maxX, int maxY) :
+		_minX(minX), _minY(minY), _minZ(std::numeric_limits<int>::min()),
+		_maxX(maxX), _maxY(maxY), _maxZ(std::numeric_limits<int>::max()) {}
+
+	/**
+	 * The region that contains everything.
+	 */
+	static Region everything() {
+
+		return Region(
+				std::numeric_limits<int>::min(),
+				std::numeric_limits<int>::min(),
+				std::numeric_limits<int>::min(),
+				std::numeric_limits<int>::max(),
+				std::numeric_limits<int>::max(),
+				std::numeric_limits<int>::max());
+	}
+
+	int minX() const { return _minX; }
+	int minY() const { return _minY; }
+	int minZ() const { return _minZ; }
+	int maxX() const { return _maxX; }
+	int maxY() const { return _maxY; }
+	int maxZ() const { return _maxZ; }
+
+	bool isEmpty() const {
+
+		return _minX > _maxX || _minY > _maxY || _minZ > _maxZ;
+	}
+
+	bool isEverything() const {
+
+		return contains(everything());
+	}
+
+	/**
+	 * Returns true, if the given region is completely inside this region.
+	 */
+	bool contains(const Region& other) const {
+
+		if (other.isEmpty())
+			return true;
+
+		if (isEmpty())
+			return false;
+
+		return
+				_minX <= other._minX && _maxX >= other._maxX &&
+				_minY <= other._minY && _maxY >= other._maxY &&
+				_minZ <= other._minZ && _maxZ >= other._maxZ;
+	}
+
+	/**
+	 * Returns true, if this region and the given region overlap.
+	 */
+	bool intersects(const Region& other) const {
+
+		if (isEmpty() || other.isEmpty())
+			return false;
+
+		return
+				_minX <= other._maxX && _maxX >= other._minX &&
+				_minY <= other._maxY && _maxY >= other._minY &&
+				_minZ <= other._maxZ && _maxZ >= other._minZ;
+	}
+
+	/**
+	 * Extend this region to the bounding box of this and the given region.
+	 */
+	Region& unite(const Region& other) {
+
+		if (other.isEmpty())
+			return *this;
+
+		if (isEmpty())
+			return (*this = other);
+
+		_minX = std::min(_minX, other._minX);
+		_minY = std::min(_minY, other._minY);
+		_minZ = std::min(_minZ, other._minZ);
+		_maxX = std::max(_maxX, other._maxX);
+		_maxY = std::max(_maxY, other._maxY);
+		_maxZ = std::max(_maxZ, other._maxZ);
+
+		return *this;
+	}
+
+	bool operator==(const Region& other) const {
+
+		if (isEmpty() && other.isEmpty())
+			return true;
+
+		return
+				_minX == other._minX && _maxX == other._maxX &&
+				_minY == other._minY && _maxY == other._maxY &&
+				_minZ == other._minZ && _maxZ == other._maxZ;
+	}
+
+	bool operator!=(const Region& other) const {
+
+		return !(*this == other);
+	}
+
+private:
+
+	int _minX, _minY, _minZ;
+	int _maxX, _maxY, _maxZ;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Region& region) {
+
+	if (region.isEmpty())
+		return out << "[empty]";
+
+	if (region.isEverything())
+		return out << "[everything]";
+
+	return out
+			<< "[" << region.minX() << ", " << region.minY() << ", " << region.minZ()
+			<< " -- " << region.maxX() << ", " << region.maxY() << ", " << region.maxZ() << "]";
+}
+
+} // namespace pipeline
+
+#endif // PIPELINE_REGION_H__
+
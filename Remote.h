@@ -0,0 +1,354 @@
+#ifndef PIPELINE_REMOTE_H__
+#define PIPELINE_REMOTE_H__
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+#include <util/foreach.h>
+#include "Logging.h"
+#include "Persistence.h"
+#include "RemoteConnection.h"
+#include "SimpleProcessNode.h"
+
+namespace pipeline {
+
+struct RemoteError : virtual PipelineError {};
+
+/**
+ * Makes the data of an output available to other processes. RemoteOutput is
+ * a sink, whose input "data" is connected to a local output. RemoteInputs in
+ * other processes connect to the port of the RemoteOutput, receive Modified
+ * signals of the local output, and request the serialized data on updates.
+ * The data is serialized with the Persistence trait of T, see Persistence.h.
+ *
+ * Together with RemoteInput, a process node graph can be partitioned into
+ * subgraphs in several processes:
+ *
+ * <code>
+ * // process A
+ * RemoteOutput<Image> remote(4711);
+ * remote.setInput(reader->getOutput());
+ *
+ * // process B
+ * RemoteInput<Image> remote("hostA", 4711);
+ * filter->setInput(remote.getOutput());
+ * </code>
+ */
+template <typename T>
+class RemoteOutput : public SimpleProcessNode<> {
+
+	BOOST_STATIC_ASSERT(Persistence<T>::enabled);
+
+public:
+
+	/**
+	 * Create a remote output and start listening for RemoteInputs.
+	 *
+	 * @param port    The port to listen on, 0 for any free port.
+	 * @param address The local address to listen on, see RemoteServer.
+	 */
+	RemoteOutput(unsigned short port, const std::string& address = std::string()) :
+		_version(0) {
+
+		registerInput(_data, "data");
+
+		_data.registerCallback(&RemoteOutput<T>::onModified, this, signals::Transparent);
+
+		_server.reset(new RemoteServer(port, boost::bind(&RemoteOutput<T>::onConnected, this, _1), address));
+	}
+
+	~RemoteOutput() {
+
+		_server.reset();
+
+		// waits for the receiving threads, which might be updating
+		boost::mutex::scoped_lock lock(_connectionsMutex);
+		_connections.clear();
+	}
+
+	/**
+	 * Get the port the RemoteInputs can connect to.
+	 */
+	unsigned short getPort() const { return _server->getPort(); }
+
+private:
+
+	void updateOutputs() {}
+
+	void onConnected(boost::shared_ptr<RemoteConnection> connection) {
+
+		boost::mutex::scoped_lock lock(_connectionsMutex);
+
+		// closed connections are removed here, they can not remove themselves
+		// from within their handler
+		std::vector<boost::shared_ptr<RemoteConnection> > open;
+		foreach (boost::shared_ptr<RemoteConnection> c, _connections)
+			if (c->isOpen())
+				open.push_back(c);
+		_connections.swap(open);
+
+		_connections.push_back(connection);
+
+		connection->start(boost::bind(&RemoteOutput<T>::onMessage, this, connection.get(), _1, _2, _3));
+	}
+
+	void onModified(const Modified&) {
+
+		boost::uint64_t version = ++_version;
+
+		boost::mutex::scoped_lock lock(_connectionsMutex);
+
+		foreach (boost::shared_ptr<RemoteConnection> connection, _connections) {
+
+			try {
+
+				if (connection->isOpen())
+					connection->send(RemoteConnection::ModifiedMessage, version);
+
+			} catch (RemoteConnection::ConnectionError&) {
+
+				// the connection closes itself
+			}
+		}
+	}
+
+	void onMessage(RemoteConnection* connection, RemoteConnection::MessageType type, boost::uint64_t, RemoteConnection::payload_type) {
+
+		if (type != RemoteConnection::UpdateMessage)
+			return;
+
+		// the data is at least as new as this version, later versions will be
+		// announced by a Modified message
+		boost::uint64_t version = _version;
+
+		try {
+
+			try {
+
+				updateInputs();
+
+				boost::shared_ptr<T> data = _data.getSharedPointer();
+
+				if (!data)
+					UTIL_THROW_EXCEPTION(RemoteError, "input 'data' of RemoteOutput is not set");
+
+				// the locks of updateInputs() are released already, but the 
+				// upstream process node must not write the data while it is 
+				// serialized
+				boost::shared_ptr<Data> locked = _data.getSharedDataPointer();
+				boost::shared_lock<boost::shared_mutex> lock(locked->getMutex());
+
+				connection->send(
+						RemoteConnection::DataMessage,
+						version,
+						Persistence<T>::size(*data),
+						boost::bind(&Persistence<T>::write, boost::cref(*data), _1));
+
+			} catch (RemoteConnection::ConnectionError&) {
+
+				throw;
+
+			} catch (boost::exception& e) {
+
+				connection->send(RemoteConnection::ErrorMessage, version, boost::diagnostic_information(e));
+			}
+
+		} catch (RemoteConnection::ConnectionError&) {
+
+			PIPELINE_LOG_ALL(pipelinelog) << "[RemoteOutput] could not answer update request, connection closed" << std::endl;
+		}
+	}
+
+	Input<T> _data;
+
+	// the version of the data, increased with each modification
+	boost::atomic<boost::uint64_t> _version;
+
+	boost::scoped_ptr<RemoteServer> _server;
+
+	std::vector<boost::shared_ptr<RemoteConnection> > _connections;
+	boost::mutex                                      _connectionsMutex;
+};
+
+/**
+ * Receives the data of a RemoteOutput in another process. RemoteInput is a
+ * source, whose output "data" is set dirty whenever the remote output was
+ * modified. On updates, the data is requested from the remote process and
+ * deserialized with the Persistence trait of T.
+ *
+ * With prefetching enabled, the data is requested as soon as the remote
+ * output was modified, such that the transfer overlaps with the propagation of
+ * the Modified signal and the updates of other process nodes.
+ */
+template <typename T>
+class RemoteInput : public SimpleProcessNode<> {
+
+	BOOST_STATIC_ASSERT(Persistence<T>::enabled);
+
+public:
+
+	/**
+	 * Connect to a RemoteOutput.
+	 *
+	 * @param host     The host of the process that owns the RemoteOutput.
+	 * @param port     The port of the RemoteOutput.
+	 * @param prefetch If true, request the data as soon as it was modified.
+	 *
+	 * @throws RemoteConnection::ConnectionError If the remote output can not
+	 *         be reached.
+	 */
+	RemoteInput(const std::string& host, unsigned short port, bool prefetch = false) :
+		_prefetch(prefetch),
+		_version(0),
+		_numRequests(0),
+		_closed(false) {
+
+		registerOutput(_data, "data");
+
+		_connection = RemoteConnection::connect(host, port);
+		_connection->start(boost::bind(&RemoteInput<T>::onMessage, this, _1, _2, _3));
+	}
+
+	~RemoteInput() {
+
+		// waits for the receiving thread
+		_connection.reset();
+	}
+
+private:
+
+	void updateOutputs() {
+
+		RemoteConnection::payload_type payload;
+		std::string                    error;
+
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+
+			while (!_response && _error.empty() && !_closed) {
+
+				// a prefetched answer might be on its way already
+				if (_numRequests == 0)
+					request();
+
+				_responded.wait(lock);
+			}
+
+			payload.swap(_response);
+			error.swap(_error);
+		}
+
+		if (!payload)
+			UTIL_THROW_EXCEPTION(
+					RemoteError,
+					"remote update failed: " << (error.empty() ? std::string("connection closed") : error));
+
+		_data = Persistence<T>::view(payload->empty() ? 0 : &(*payload)[0], payload->size(), payload);
+	}
+
+	// assumes that _mutex is locked
+	void request() {
+
+		try {
+
+			_connection->send(RemoteConnection::UpdateMessage, _version);
+			_numRequests++;
+
+		} catch (RemoteConnection::ConnectionError&) {
+
+			_closed = true;
+		}
+	}
+
+	void onMessage(RemoteConnection::MessageType type, boost::uint64_t version, RemoteConnection::payload_type payload) {
+
+		bool modified = false;
+
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+
+			switch (type) {
+
+				case RemoteConnection::ModifiedMessage:
+
+					// answers received so far are outdated
+					_version = std::max(_version, version);
+					_response.reset();
+					modified = true;
+
+					if (_prefetch && _numRequests == 0)
+						request();
+
+					break;
+
+				case RemoteConnection::DataMessage:
+
+					_numRequests--;
+
+					// answers computed before the last modification are dropped,
+					// a waiting update will request the data again
+					if (version >= _version)
+						_response = payload;
+
+					break;
+
+				case RemoteConnection::ErrorMessage:
+
+					_numRequests--;
+					_error = std::string(payload->begin(), payload->end());
+
+					break;
+
+				case RemoteConnection::ClosedMessage:
+
+					_closed = true;
+
+					break;
+
+				default:
+
+					break;
+			}
+		}
+
+		_responded.notify_all();
+
+		if (modified)
+			setDirty(_data);
+	}
+
+	Output<T> _data;
+
+	bool _prefetch;
+
+	// the latest version announced by the remote output
+	boost::uint64_t _version;
+
+	// the number of unanswered update requests
+	unsigned int _numRequests;
+
+	// the latest answer, if it was not used yet
+	RemoteConnection::payload_type _response;
+	std::string                    _error;
+
+	bool _closed;
+
+	boost::mutex              _mutex;
+	boost::condition_variable _responded;
+
+	boost::shared_ptr<RemoteConnection> _connection;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_REMOTE_H__
+
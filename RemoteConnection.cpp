@@ -0,0 +1,330 @@
+#include <algorithm>
+
+#include <sys/socket.h>
+
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/make_shared.hpp>
+
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include "Logging.h"
+#include "RemoteConnection.h"
+
+logger::LogChannel remotelog("remotelog", "[Remote] ");
+
+namespace pipeline {
+
+util::ProgramOption optionRemoteAddress(
+		util::_module           = "pipeline",
+		util::_long_name        = "remoteAddress",
+		util::_description_text = "The local address RemoteOutputs listen on for RemoteInputs of other processes. Use "
+		                          "0.0.0.0 to accept connections from any host.",
+		util::_default_value    = "127.0.0.1");
+
+util::ProgramOption optionRemoteMaxMessageSize(
+		util::_module           = "pipeline",
+		util::_long_name        = "remoteMaxMessageSize",
+		util::_description_text = "The largest message in MB accepted from a remote connection. Connections sending larger "
+		                          "messages are closed.",
+		util::_default_value    = 1024);
+
+namespace {
+
+// type, version, and payload size
+const std::size_t HeaderSize = 1 + 8 + 8;
+
+boost::asio::io_service& getIoService() {
+
+	// only used for blocking operations, never run
+	static boost::asio::io_service ioService;
+
+	return ioService;
+}
+
+// integers are sent in little endian, independent of the hosts
+void encode(boost::uint64_t value, unsigned char* buffer) {
+
+	for (int i = 0; i < 8; i++)
+		buffer[i] = (value >> (8*i)) & 0xff;
+}
+
+boost::uint64_t decode(const unsigned char* buffer) {
+
+	boost::uint64_t value = 0;
+
+	for (int i = 0; i < 8; i++)
+		value |= static_cast<boost::uint64_t>(buffer[i]) << (8*i);
+
+	return value;
+}
+
+void copyText(const std::string& text, char* buffer) {
+
+	std::copy(text.begin(), text.end(), buffer);
+}
+
+boost::uint64_t maxPayloadSize() {
+
+	static int megabytes = optionRemoteMaxMessageSize;
+
+	return static_cast<boost::uint64_t>(std::max(megabytes, 0))*1024*1024;
+}
+
+} // anonymous namespace
+
+struct RemoteConnection::Socket {
+
+	Socket() : socket(getIoService()) {}
+
+	boost::asio::ip::tcp::socket socket;
+};
+
+struct RemoteServer::Acceptor {
+
+	Acceptor() : acceptor(getIoService()) {}
+
+	boost::asio::ip::tcp::acceptor acceptor;
+};
+
+boost::shared_ptr<RemoteConnection>
+RemoteConnection::connect(const std::string& host, unsigned short port) {
+
+	Socket* socket = new Socket();
+	boost::shared_ptr<RemoteConnection> connection(new RemoteConnection(socket));
+
+	try {
+
+		boost::asio::ip::tcp::resolver resolver(getIoService());
+		boost::asio::ip::tcp::resolver::query query(host, boost::lexical_cast<std::string>(port));
+
+		boost::asio::connect(socket->socket, resolver.resolve(query));
+		socket->socket.set_option(boost::asio::ip::tcp::no_delay(true));
+
+	} catch (boost::system::system_error& e) {
+
+		UTIL_THROW_EXCEPTION(
+				ConnectionError,
+				"could not connect to " << host << ":" << port << ": " << e.what());
+	}
+
+	LOG_DEBUG(remotelog) << "connected to " << host << ":" << port << std::endl;
+
+	return connection;
+}
+
+RemoteConnection::RemoteConnection(Socket* socket) :
+	_socket(socket),
+	_open(true) {}
+
+RemoteConnection::~RemoteConnection() {
+
+	close();
+
+	if (!_receiver.joinable())
+		return;
+
+	if (_receiver.get_id() == boost::this_thread::get_id()) {
+
+		LOG_ERROR(remotelog) << "connection destructed by its own handler" << std::endl;
+		_receiver.detach();
+		return;
+	}
+
+	_receiver.join();
+}
+
+void
+RemoteConnection::start(handler_type handler) {
+
+	_handler  = handler;
+	_receiver = boost::thread(boost::bind(&RemoteConnection::receive, this));
+}
+
+void
+RemoteConnection::send(MessageType type, boost::uint64_t version) {
+
+	send(type, version, 0, writer_type());
+}
+
+void
+RemoteConnection::send(MessageType type, boost::uint64_t version, const std::string& text) {
+
+	send(type, version, text.size(), boost::bind(&copyText, boost::cref(text), _1));
+}
+
+void
+RemoteConnection::send(MessageType type, boost::uint64_t version, std::size_t size, writer_type write) {
+
+	std::vector<char> buffer(HeaderSize + size);
+
+	unsigned char* header = reinterpret_cast<unsigned char*>(&buffer[0]);
+
+	header[0] = type;
+	encode(version, header + 1);
+	encode(size, header + 9);
+
+	if (size > 0)
+		write(&buffer[HeaderSize]);
+
+	boost::mutex::scoped_lock lock(_sendMutex);
+
+	if (!_open)
+		UTIL_THROW_EXCEPTION(ConnectionError, "connection is closed");
+
+	boost::system::error_code error;
+	boost::asio::write(_socket->socket, boost::asio::buffer(buffer), error);
+
+	if (error)
+		UTIL_THROW_EXCEPTION(ConnectionError, "could not send message: " << error.message());
+}
+
+void
+RemoteConnection::close() {
+
+	if (_open.exchange(false) == false)
+		return;
+
+	// wakes up the receiving thread
+	boost::system::error_code error;
+	_socket->socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+}
+
+void
+RemoteConnection::receive() {
+
+	while (true) {
+
+		unsigned char header[HeaderSize];
+
+		boost::system::error_code error;
+		boost::asio::read(_socket->socket, boost::asio::buffer(header, HeaderSize), error);
+
+		if (error)
+			break;
+
+		boost::uint64_t size = decode(header + 9);
+
+		// the size was sent by an unknown peer
+		if (size > maxPayloadSize()) {
+
+			LOG_ERROR(remotelog) << "received message of " << size << " bytes exceeds remoteMaxMessageSize, closing connection" << std::endl;
+			break;
+		}
+
+		boost::shared_ptr<std::vector<char> > payload;
+
+		try {
+
+			payload = boost::make_shared<std::vector<char> >(size);
+
+		} catch (std::bad_alloc&) {
+
+			LOG_ERROR(remotelog) << "could not allocate message of " << size << " bytes, closing connection" << std::endl;
+			break;
+		}
+
+		if (payload->size() > 0)
+			boost::asio::read(_socket->socket, boost::asio::buffer(*payload), error);
+
+		if (error)
+			break;
+
+		PIPELINE_LOG_ALL(remotelog)
+				<< "received message " << static_cast<int>(header[0])
+				<< " with " << payload->size() << " bytes" << std::endl;
+
+		try {
+
+			_handler(static_cast<MessageType>(header[0]), decode(header + 1), payload);
+
+		} catch (...) {
+
+			LOG_ERROR(remotelog) << "message handler threw an exception: " << boost::current_exception_diagnostic_information() << std::endl;
+		}
+	}
+
+	LOG_DEBUG(remotelog) << "connection closed" << std::endl;
+
+	close();
+
+	_handler(ClosedMessage, 0, payload_type());
+}
+
+RemoteServer::RemoteServer(unsigned short port, accept_handler_type onAccept, const std::string& address) :
+	_acceptor(new Acceptor()),
+	_onAccept(onAccept),
+	_closed(false) {
+
+	std::string bindAddress = (address.empty() ? optionRemoteAddress.as<std::string>() : address);
+
+	if (bindAddress.empty())
+		bindAddress = "127.0.0.1";
+
+	try {
+
+		boost::asio::ip::tcp::endpoint endpoint(boost::asio::ip::address::from_string(bindAddress), port);
+
+		_acceptor->acceptor.open(endpoint.protocol());
+		_acceptor->acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+		_acceptor->acceptor.bind(endpoint);
+		_acceptor->acceptor.listen();
+
+	} catch (boost::system::system_error& e) {
+
+		UTIL_THROW_EXCEPTION(
+				RemoteConnection::ConnectionError,
+				"could not listen on " << bindAddress << ":" << port << ": " << e.what());
+	}
+
+	LOG_DEBUG(remotelog) << "listening on " << bindAddress << ":" << getPort() << std::endl;
+
+	_thread = boost::thread(boost::bind(&RemoteServer::accept, this));
+}
+
+RemoteServer::~RemoteServer() {
+
+	_closed = true;
+
+	// wakes up the accepting thread
+	::shutdown(_acceptor->acceptor.native_handle(), SHUT_RDWR);
+
+	_thread.join();
+}
+
+unsigned short
+RemoteServer::getPort() const {
+
+	return _acceptor->acceptor.local_endpoint().port();
+}
+
+void
+RemoteServer::accept() {
+
+	while (!_closed) {
+
+		RemoteConnection::Socket* socket = new RemoteConnection::Socket();
+		boost::shared_ptr<RemoteConnection> connection(new RemoteConnection(socket));
+
+		boost::system::error_code error;
+		_acceptor->acceptor.accept(socket->socket, error);
+
+		if (error) {
+
+			if (!_closed)
+				LOG_ERROR(remotelog) << "could not accept connection: " << error.message() << std::endl;
+
+			break;
+		}
+
+		socket->socket.set_option(boost::asio::ip::tcp::no_delay(true), error);
+
+		LOG_DEBUG(remotelog) << "accepted connection from " << socket->socket.remote_endpoint(error) << std::endl;
+
+		_onAccept(connection);
+	}
+}
+
+} // namespace pipeline
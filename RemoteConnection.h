@@ -0,0 +1,179 @@
+#ifndef PIPELINE_REMOTE_CONNECTION_H__
+#define PIPELINE_REMOTE_CONNECTION_H__
+
+#include <string>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "exceptions.h"
+
+namespace pipeline {
+
+/**
+ * A message based TCP connection between two processes, used by RemoteInput
+ * and RemoteOutput to forward signals and data of a process node graph. A
+ * message consists of a type, a version, and a payload. Received messages are
+ * passed to a handler on a thread owned by the connection. Connections that
+ * announce a message larger than the program option 'remoteMaxMessageSize' 
+ * are closed.
+ */
+class RemoteConnection {
+
+public:
+
+	struct ConnectionError : virtual PipelineError {};
+
+	enum MessageType {
+
+		// the connection was closed, passed to the handler only
+		ClosedMessage = 0,
+
+		// the remote data was modified, the version increased
+		ModifiedMessage = 1,
+
+		// a request for the current data
+		UpdateMessage = 2,
+
+		// the serialized data, answers an UpdateMessage
+		DataMessage = 3,
+
+		// the update failed, the payload is the error description
+		ErrorMessage = 4
+	};
+
+	typedef boost::shared_ptr<const std::vector<char> > payload_type;
+
+	typedef boost::function<void(MessageType, boost::uint64_t, payload_type)> handler_type;
+
+	typedef boost::function<void(char*)> writer_type;
+
+	/**
+	 * Connect to a RemoteServer.
+	 *
+	 * @throws ConnectionError If the server can not be reached.
+	 */
+	static boost::shared_ptr<RemoteConnection> connect(const std::string& host, unsigned short port);
+
+	/**
+	 * Closes the connection and waits for the receiving thread. Must not be
+	 * called from within the handler.
+	 */
+	~RemoteConnection();
+
+	/**
+	 * Start receiving messages. The handler is called for each message on the
+	 * receiving thread, and once with a ClosedMessage when the connection ends.
+	 */
+	void start(handler_type handler);
+
+	/**
+	 * Send a message without payload. Can be called from any thread.
+	 *
+	 * @throws ConnectionError If the connection is closed.
+	 */
+	void send(MessageType type, boost::uint64_t version);
+
+	/**
+	 * Send a message with a text payload.
+	 */
+	void send(MessageType type, boost::uint64_t version, const std::string& text);
+
+	/**
+	 * Send a message with a payload of the given size, which is created by the
+	 * write function.
+	 */
+	void send(MessageType type, boost::uint64_t version, std::size_t size, writer_type write);
+
+	/**
+	 * Close the connection. Blocked calls to send() fail, the handler receives
+	 * a ClosedMessage.
+	 */
+	void close();
+
+	/**
+	 * Returns true, if the connection was not closed.
+	 */
+	bool isOpen() const { return _open; }
+
+private:
+
+	// servers create connections for accepted sockets
+	friend class RemoteServer;
+
+	struct Socket;
+
+	RemoteConnection(Socket* socket);
+
+	void receive();
+
+	boost::scoped_ptr<Socket> _socket;
+
+	// serializes concurrent sends
+	boost::mutex _sendMutex;
+
+	handler_type _handler;
+
+	boost::thread _receiver;
+
+	boost::atomic<bool> _open;
+};
+
+/**
+ * Accepts RemoteConnections on a TCP port.
+ */
+class RemoteServer {
+
+public:
+
+	typedef boost::function<void(boost::shared_ptr<RemoteConnection>)> accept_handler_type;
+
+	/**
+	 * Start listening on a port. Accepted connections are passed to the
+	 * handler on a thread owned by the server.
+	 *
+	 * @param port     The port to listen on, 0 for any free port.
+	 * @param onAccept Called for each accepted connection.
+	 * @param address  The local address to listen on. If empty, the program 
+	 *                 option 'remoteAddress' is used, which defaults to the 
+	 *                 loopback interface.
+	 *
+	 * @throws RemoteConnection::ConnectionError If the port can not be used.
+	 */
+	RemoteServer(unsigned short port, accept_handler_type onAccept, const std::string& address = std::string());
+
+	/**
+	 * Stops accepting connections. Already accepted connections stay open.
+	 */
+	~RemoteServer();
+
+	/**
+	 * Get the port this server is listening on.
+	 */
+	unsigned short getPort() const;
+
+private:
+
+	struct Acceptor;
+
+	void accept();
+
+	boost::scoped_ptr<Acceptor> _acceptor;
+
+	accept_handler_type _onAccept;
+
+	boost::atomic<bool> _closed;
+
+	boost::thread _thread;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_REMOTE_CONNECTION_H__
+
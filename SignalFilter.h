@@ -1,11 +1,13 @@
 #ifndef PIPELINE_SIGNAL_FILTER_H__
 #define PIPELINE_SIGNAL_FILTER_H__
 
+#include <boost/shared_ptr.hpp>
+
 #include <signals/Slot.h>
-#include <signals/Slots.h>
 #include "Output.h"
 #include "Input.h"
 #include "Inputs.h"
+#include "LazySlots.h"
 
 /**
  * Defines the class template SignalFilter. Use this to create signal filters in 
@@ -84,8 +86,8 @@ protected:
 		// establish callback connection to method of this class
 		output.registerCallback(boost::function<void(SignalType&)>(boost::bind(&MyType::onSignalMulti, this, _1)), processNode, signals::Transparent);
 
-		// connect slot of this class for signal sending
-		inputs.registerSlots(_slots);
+		// slots for signal sending are connected to the inputs on demand
+		_slots.reset(new LazySlots<SignalType>(inputs));
 
 		// delegate to other signals filters
 		ParentType::filterBackward(output, inputs, processNode);
@@ -110,8 +112,11 @@ private:
 		if (signal.processed)
 			return;
 
-		// for each registered input to this multi-slot
-		for (unsigned int i = 0; i < _slots.size(); i++) {
+		if (!_slots)
+			return;
+
+		// for each input of the multi-input
+		for (unsigned int i = 0; i < _slots->size(); i++) {
 
 			// create a copy of the signal
 			SignalType copy = signal;
@@ -120,7 +125,7 @@ private:
 			this->filter(copy, i);
 
 			// send signal to registered inputs
-			_slots[i](copy);
+			_slots->send(i, copy);
 
 			// if signal was processed, we are done
 			if (copy.processed) {
@@ -132,7 +137,7 @@ private:
 	}
 
 	signals::Slot<SignalType>  _slot;
-	signals::Slots<SignalType> _slots;
+	boost::shared_ptr<LazySlots<SignalType> > _slots;
 };
 
 template <typename FallbackSignalType>
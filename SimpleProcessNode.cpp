@@ -1,46 +1,94 @@
+#include <algorithm>
+#include <typeinfo>
+
+#include <boost/make_shared.hpp>
+
+#include <util/foreach.h>
 #include <util/ProgramOptions.h>
+#include <util/typename.h>
 #include "InputSignals.h"
 #include "ProcessNode.h"
 #include "SimpleProcessNode.h"
+#include "ThreadPool.h"
+#include "UpdateScheduler.h"
 
 logger::LogChannel simpleprocessnodelog("simpleprocessnodelog");
 
 namespace pipeline {
 
-util::ProgramOption optionNumThreads(
+util::ProgramOption optionCoalesceModified(
 		util::_module           = "pipeline",
-		util::_long_name        = "numThreads",
-		util::_description_text = "Set the number of additional threads to parallelize independent processes.",
-		util::_default_value    = 0);
+		util::_long_name        = "coalesceModified",
+		util::_description_text = "Forward Modified signals only once for each output of a process node, until this output "
+		                          "is asked for an update again.");
 
-template <typename LockingStrategy>
-int SimpleProcessNode<LockingStrategy>::_numThreads = 0;
+util::ProgramOption optionCancelSupersededUpdates(
+		util::_module           = "pipeline",
+		util::_long_name        = "cancelSupersededUpdates",
+		util::_description_text = "Abandon input updates and the computation of outputs as soon as the inputs of a process "
+		                          "node change during its update.");
 
-template <typename LockingStrategy>
-boost::mutex SimpleProcessNode<LockingStrategy>::_threadCountMutex;
+util::ProgramOption optionCompiledDispatch(
+		util::_module           = "pipeline",
+		util::_long_name        = "compiledDispatch",
+		util::_description_text = "Resolve the upstream process nodes once after each change of the graph, and replace "
+		                          "Update signals between process nodes by direct calls. Modified signals are always sent "
+		                          "via the signal library.");
+
+util::ProgramOption optionPrefetchOutputs(
+		util::_module           = "pipeline",
+		util::_long_name        = "prefetchOutputs",
+		util::_description_text = "Update process nodes speculatively on idle threads as soon as their outputs were "
+		                          "modified, such that later update requests find them up-to-date.");
+
+util::ProgramOption optionFuseChains(
+		util::_module           = "pipeline",
+		util::_long_name        = "fuseChains",
+		util::_description_text = "Update linear chains of process nodes with a single input each iteratively from the head "
+		                          "of the chain, instead of propagating Update signals through every member.");
 
 template <typename LockingStrategy>
 SimpleProcessNode<LockingStrategy>::SimpleProcessNode(std::string name) :
 	_numInputs(0),
 	_numMultiInputs(0),
 	_numOutputs(0),
-	_name(name) {
-
-	_numThreads = optionNumThreads;
-}
+	_coalesceModified(optionCoalesceModified),
+	_compiledDispatch(optionCompiledDispatch),
+	_batchable(false),
+	_fuseChains(optionFuseChains),
+	_fusedEpoch(0),
+	_fusedCompiled(false),
+	_modificationGeneration(0),
+	_updateGeneration(0),
+	_cancelSuperseded(optionCancelSupersededUpdates),
+	_prefetch(optionPrefetchOutputs.as<bool>()),
+	_prefetchScheduled(false),
+	_speculative(false),
+	_outputCacheSize(0),
+	_evictable(false),
+	_affinity(AnyDomain),
+	_stateVersion(0),
+	_estimatedCost(0),
+	_name(name) {}
 
 template <typename LockingStrategy>
 SimpleProcessNode<LockingStrategy>::~SimpleProcessNode() {
 
-	foreach (signals::SlotsBase* slot, _multiInputUpdates)
-		delete slot;
+	if (_evictable && MemoryManager::isEnabled())
+		MemoryManager::getInstance().remove(this);
+
+	foreach (LazySlots<Update>* slots, _multiInputUpdates)
+		delete slots;
+
+	foreach (DirtyFlags* flags, _multiInputDirty)
+		delete flags;
 }
 
 template <typename LockingStrategy>
 void
 SimpleProcessNode<LockingStrategy>::registerInput(InputBase& input, std::string name, InputType inputType) {
 
-	boost::mutex::scoped_lock inputLock(_inputMutex);
+	boost::recursive_mutex::scoped_lock inputLock(_inputMutex);
 
 	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " got a new input " << name << std::endl;
 
@@ -63,7 +111,7 @@ SimpleProcessNode<LockingStrategy>::registerInput(InputBase& input, std::string
 
 		// Optional inputs are non-dirty by default (such that the output will
 		// be computed, regardless of their presence).
-		_inputDirty[numInput] = false;
+		_inputDirty.reset(numInput);
 
 		// optional inputs need not be present to update the output
 		_inputRequired.push_back(false);
@@ -104,9 +152,11 @@ SimpleProcessNode<LockingStrategy>::registerInputs(MultiInput& input, std::strin
 
 	int numMultiInput = _numMultiInputs;
 
-	_multiInputDirty.push_back(std::vector<bool>());
+	_multiInputDirty.push_back(new DirtyFlags());
 	_multiInputDirtys.push_back(std::vector<int>());
-	_multiInputUpdates.push_back(new signals::Slots<Update>());
+	_multiInputUpdates.push_back(new LazySlots<Update>(input));
+	_pendingChanges.push_back(MultiInputChanges());
+	_multiInputChanges.push_back(MultiInputChanges());
 
 	// create signal callbacks that store the number of the multi-input with them
 	boost::function<void(InputAddedBase&)>         funOnInputAdded    = boost::bind(&SimpleProcessNode<LockingStrategy>::onInputAdded,         this, _1, numMultiInput);
@@ -118,8 +168,8 @@ SimpleProcessNode<LockingStrategy>::registerInputs(MultiInput& input, std::strin
 	input.registerCallback(funOnInputsCleared, this, signals::Transparent);
 	input.registerCallbacks(funOnModified, this, signals::Transparent);
 
-	// register the appropriate update signal for this input
-	input.registerSlots(*_multiInputUpdates[numMultiInput]);
+	// the update slots of the individual inputs are created on demand, see 
+	// sendUpdateSignals()
 
 	_multiInputNums[&input] = numMultiInput;
 
@@ -139,6 +189,16 @@ SimpleProcessNode<LockingStrategy>::registerOutput(OutputBase& output, std::stri
 	int numOutput = _numOutputs;
 
 	_outputDirty.push_back(true);
+	_outputNotified.push_back(false);
+	_persistentOutputs.push_back(boost::shared_ptr<PersistentOutputBase>());
+
+	{
+		boost::mutex::scoped_lock lock(_regionMutex);
+
+		// new outputs have to be computed completely
+		_outputModifiedRegion.push_back(Region::everything());
+		_outputRequestedRegion.push_back(Region());
+	}
 
 	_modified.addSlot();
 
@@ -160,22 +220,40 @@ template <typename LockingStrategy>
 void
 SimpleProcessNode<LockingStrategy>::setDependency(InputBase& input, OutputBase& output) {
 
-	int inputNum  = _inputNums[&input];
-	int outputNum = _outputNums[&output];
-
-	_inputDirtys[inputNum].push_back(outputNum);
+	addPortDependency(&input, _inputNums[&input], _outputNums[&output]);
 }
 
 template <typename LockingStrategy>
 void
 SimpleProcessNode<LockingStrategy>::setDependency(MultiInput& input, OutputBase& output) {
 
-	int multiInputNum = _multiInputNums[&input];
-	int outputNum     = _outputNums[&output];
+	addPortDependency(&input, _multiInputNums[&input], _outputNums[&output]);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::addPortDependency(InputBase*, unsigned int inputNum, unsigned int outputNum) {
+
+	_inputDirtys[inputNum].push_back(outputNum);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::addPortDependency(MultiInput*, unsigned int multiInputNum, unsigned int outputNum) {
 
 	_multiInputDirtys[multiInputNum].push_back(outputNum);
 }
 
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::checkPortNumber(unsigned int declared, unsigned int registered, const std::string& name) {
+
+	if (declared != registered)
+		UTIL_THROW_EXCEPTION(
+				PortMismatch,
+				"port " << name << " was declared with number " << declared << ", but is registered as number " << registered);
+}
+
 /**
  * Explicitly update this process node.
  */
@@ -183,412 +261,1707 @@ template <typename LockingStrategy>
 void
 SimpleProcessNode<LockingStrategy>::updateInputs() {
 
+	ProfilingTimer waitTimer;
+
 	boost::mutex::scoped_lock lock(_updateMutex);
 
+	if (NodeStatistics* statistics = getStatistics())
+		statistics->updateMutexWaitTime += waitTimer.elapsed();
+
 	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " input update requested by user" << std::endl;
 
+	// update the whole dirty upstream graph at once, such that the following 
+	// update signals find it up-to-date
+	beginUpdate();
+
+	_requestedRegion = Region::everything();
+
+	if (UpdateScheduler::isEnabled())
+		UpdateScheduler(*this).run();
+
 	sendUpdateSignals();
 };
 
 template <typename LockingStrategy>
 void
-SimpleProcessNode<LockingStrategy>::setDirty(OutputBase& output) {
-
-	/* Now, here we can have a race condition: While updating our outputs, right
-	 * before setting _outputDirty to false for every output, some other thread
-	 * might call setDirty(). In this case, this call will have no effect.
-	 *
-	 * What if we set _outputDirty to false *before* we start updating the
-	 * outputs? In the worst case, we don't see the effect of setDirty(), which
-	 * doesn't matter, since we update the outputs anyway. Without a race
-	 * condition, the output will be set dirty during the update and stay dirty
-	 * after it. Since simultaneously we also send a Modified signal this is
-	 * equivalent to a setDirty() call after the update. Handling is delegated
-	 * to the next process node.
-	 */
-
-	if (_outputNums.count(&output) == 0)
-		LOG_ERROR(simpleprocessnodelog)
-				<< getLogPrefix() << " invalid request to set dirty an unknown output" << std::endl;
-
-	unsigned int outputNum = _outputNums[&output];
+SimpleProcessNode<LockingStrategy>::updateInputs(const Region& region) {
 
-	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " user set dirty output " << outputNum << std::endl;
+	ProfilingTimer waitTimer;
 
-	_outputDirty[outputNum] = true;
+	boost::mutex::scoped_lock lock(_updateMutex);
 
-	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " sending modified to output " << outputNum << std::endl;
+	if (NodeStatistics* statistics = getStatistics())
+		statistics->updateMutexWaitTime += waitTimer.elapsed();
 
-	_modified[outputNum]();
-}
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " input update of region " << region << " requested by user" << std::endl;
 
-template <typename LockingStrategy>
-void
-SimpleProcessNode<LockingStrategy>::onInputModified(const Modified& /*signal*/, int numInput) {
+	beginUpdate();
 
-	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " input " << numInput << " was modified" << std::endl;
+	_requestedRegion = region;
 
-	boost::mutex::scoped_lock lock(_inputDirtyMutex);
+	if (UpdateScheduler::isEnabled())
+		UpdateScheduler(*this).run();
 
-	_inputDirty[numInput] = true;
+	if (region.isEverything()) {
 
-	sendModifiedSignals(numInput);
-}
+		sendUpdateSignals(-1, region);
+		return;
+	}
 
-template <typename LockingStrategy>
-void
-SimpleProcessNode<LockingStrategy>::onInputSet(const InputSetBase& /*signal*/, int numInput) {
+	// the dirty inputs are up-to-date only within the region afterwards
+	std::vector<unsigned int> dirtyInputs;
+	for (int i = 0; i < _numInputs; i++)
+		if (_inputDirty.test(i))
+			dirtyInputs.push_back(i);
 
-	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " input " << numInput << " got a new input" << std::endl;
+	std::vector<std::vector<unsigned int> > dirtyMultiInputs(_numMultiInputs);
+	for (int i = 0; i < _numMultiInputs; i++)
+		for (unsigned int j = 0; j < _multiInputDirty[i]->size(); j++)
+			if (_multiInputDirty[i]->test(j))
+				dirtyMultiInputs[i].push_back(j);
 
-	boost::mutex::scoped_lock lock(_inputDirtyMutex);
+	sendUpdateSignals(-1, region);
 
-	_inputDirty[numInput] = true;
+	foreach (unsigned int i, dirtyInputs)
+		_inputDirty.set(i);
 
-	// since InputSet* signals are modified signals, we have to treat them as 
-	// such as well and propagate the Modified signal
-	sendModifiedSignals(numInput);
+	for (int i = 0; i < _numMultiInputs; i++)
+		foreach (unsigned int j, dirtyMultiInputs[i])
+			_multiInputDirty[i]->set(j);
 }
 
 template <typename LockingStrategy>
-void
-SimpleProcessNode<LockingStrategy>::onInputSetToSharedPointer(const InputSetToSharedPointerBase& /*signal*/, int numInput) {
-
-	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " input " << numInput << " got a new input (shared pointer)" << std::endl;
+boost::shared_future<void>
+SimpleProcessNode<LockingStrategy>::updateInputsAsync(continuation_type continuation) {
 
-	boost::mutex::scoped_lock lock(_inputDirtyMutex);
+	// keeps this process node alive until the update is done -- throws 
+	// before any request gets installed, if we are not owned by a shared 
+	// pointer
+	boost::shared_ptr<ProcessNode> self = getSelfSharedPointer();
 
-	// shared pointer inputs are never dirty
-	_inputDirty[numInput] = false;
+	boost::shared_ptr<AsyncUpdate> request;
+	bool schedule = false;
 
-	// therefore, we have to set the outputs dirty explicitly
-	setOutputsDirty();
+	{
+		boost::mutex::scoped_lock lock(_asyncMutex);
 
-	// shared pointers can't talk, so send the modified signal ourselves
-	sendModifiedSignals(numInput);
-}
+		if (!_pendingAsyncUpdate) {
 
-template <typename LockingStrategy>
-void
-SimpleProcessNode<LockingStrategy>::onInputAdded(const InputAddedBase& /*signal*/, int numMultiInput) {
+			_pendingAsyncUpdate = boost::make_shared<AsyncUpdate>();
+			_pendingAsyncUpdate->future = _pendingAsyncUpdate->promise.get_future().share();
 
-	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " multi-input " << numMultiInput << " got a new input" << std::endl;
+			schedule = true;
 
-	boost::mutex::scoped_lock lock(_inputDirtyMutex);
+		} else {
 
-	// add a new dirty flag for this multi-input's new input
-	_multiInputDirty[numMultiInput].push_back(true);
-}
+			PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " merging asynchronous update request" << std::endl;
+		}
 
-template <typename LockingStrategy>
-void
-SimpleProcessNode<LockingStrategy>::onInputsCleared(const InputsCleared& /*signal*/, int numMultiInput) {
+		if (continuation)
+			_pendingAsyncUpdate->continuations.push_back(continuation);
 
-	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " multi-input " << numMultiInput << " was cleared" << std::endl;
+		request = _pendingAsyncUpdate;
+	}
 
-	boost::mutex::scoped_lock lock(_inputDirtyMutex);
+	if (schedule)
+		ThreadPool::getInstance().schedule(boost::bind(&SimpleProcessNode<LockingStrategy>::asyncUpdate, this, self));
 
-	// clear all flags for this multi-input
-	_multiInputDirty[numMultiInput].clear();
+	return request->future;
 }
 
 template <typename LockingStrategy>
 void
-SimpleProcessNode<LockingStrategy>::onMultiInputModified(const Modified& /*signal*/, int numInput, int numMultiInput) {
+SimpleProcessNode<LockingStrategy>::asyncUpdate(boost::shared_ptr<ProcessNode> /*self*/) {
 
-	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " multi-input " << numMultiInput << " was modified in input " << numInput << std::endl;
+	// from now on, requests have to be answered by a new update, since this 
+	// one might miss modifications made after they were issued
+	boost::shared_ptr<AsyncUpdate> request;
 
-	boost::mutex::scoped_lock lock(_inputDirtyMutex);
+	{
+		boost::mutex::scoped_lock lock(_asyncMutex);
+		request.swap(_pendingAsyncUpdate);
+	}
 
-	_multiInputDirty[numMultiInput][numInput] = true;
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " performing asynchronous update" << std::endl;
 
-	sendModifiedSignals(numInput, numMultiInput);
-}
+	boost::exception_ptr exception;
 
-template <typename LockingStrategy>
-void
-SimpleProcessNode<LockingStrategy>::onUpdate(const Update& /*signal*/, int numOutput) {
+	try {
 
-	boost::mutex::scoped_lock lock(_updateMutex);
+		updateInputs();
 
-	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " input update requested by another process node via output " << numOutput << std::endl;
+	} catch (...) {
 
-	{
-		boost::mutex::scoped_lock inputDirtyLock(_inputDirtyMutex);
+		exception = boost::current_exception();
+	}
 
-		if (haveDirtyInput()) {
+	foreach (continuation_type& continuation, request->continuations) {
 
-			inputDirtyLock.unlock();
+		try {
 
-			// our inputs changed -- need to recompute the output
-			setOutputsDirty();
+			continuation(exception);
 
-			PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " I have some dirty inputs -- sending update signals" << std::endl;
+		} catch (...) {
 
-			sendUpdateSignals(numOutput);
+			LOG_ERROR(simpleprocessnodelog)
+					<< getLogPrefix() << " continuation of asynchronous update threw an exception: "
+					<< boost::current_exception_diagnostic_information() << std::endl;
 		}
 	}
 
-	/* Here a race condition can occur: While we are sending the update signals
-	 * to the inputs, a Modified signal might have been sent by another thread,
-	 * resulting in a dirty input right after the update. This is okay, since we
-	 * also send Modified to the next node. But with the following code, we set
-	 * _outputDirty to false and thus overwrote the setting of the Modified
-	 * signal we received earlier. The result is that we don't update our
-	 * output, since we don't know that it is dirty.
-	 *
-	 * One solution would be to set _outputDirty to true whenever we enter this
-	 * function and haveDirtyInput() is true. In this case, do we need
-	 * _outputDirty at all? Yes, the user can set the output dirty even if the
-	 * inputs didn't change.
-	 */
-
-	if (haveDirtyOutput() && requiredInputsPresent()) {
-
-		/* Here, the setDirty() race condition can occur. However, it won't hurt
-		 * since we are about to update the outputs anyway.
-		 */
+	if (exception)
+		request->promise.set_exception(exception);
+	else
+		request->promise.set_value();
+}
 
-		setOutputsDirty(false);
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::setDirty(OutputBase& output) {
 
-		// lock inputs, outputs, and update outputs
-		lockInputs(0);
+	setDirty(output, Region::everything());
+}
 
-	} else {
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::setDirty(OutputBase& output, const Region& region) {
 
-		if (!requiredInputsPresent()) {
+	/* Now, here we can have a race condition: While updating our outputs, right
+	 * before setting _outputDirty to false for every output, some other thread
+	 * might call setDirty(). In this case, this call will have no effect.
+	 *
+	 * What if we set _outputDirty to false *before* we start updating the
+	 * outputs? In the worst case, we don't see the effect of setDirty(), which
+	 * doesn't matter, since we update the outputs anyway. Without a race
+	 * condition, the output will be set dirty during the update and stay dirty
+	 * after it. Since simultaneously we also send a Modified signal this is
+	 * equivalent to a setDirty() call after the update. Handling is delegated
+	 * to the next process node.
+	 */
 
-			LOG_ERROR(simpleprocessnodelog) << getLogPrefix() << " asking for update, but not all required inputs are present!" << std::endl;
-		}
+	if (_outputNums.count(&output) == 0)
+		LOG_ERROR(simpleprocessnodelog)
+				<< getLogPrefix() << " invalid request to set dirty an unknown output" << std::endl;
 
-		PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " outputs are still up-to-date" << std::endl;
-	}
+	setDirtyOutput(_outputNums[&output], region);
 }
 
 template <typename LockingStrategy>
 void
-SimpleProcessNode<LockingStrategy>::sendUpdateSignals(int numOutput) {
-
-	boost::mutex::scoped_lock inputLock(_inputMutex);
+SimpleProcessNode<LockingStrategy>::setDirtyOutput(unsigned int outputNum, const Region& region) {
 
-	boost::thread_group workers;
-
-	// TODO: this number can be subject to race conditions
-	unsigned int numDirties = numDirtyInputs();
-
-	// ask all dirty inputs for updates
-	for (int i = 0; i < _numInputs; i++) {
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " user set dirty output " << outputNum << std::endl;
 
-		if (!inputOutputDepends(i, numOutput))
-			continue;
+	_outputDirty.set(outputNum);
 
-		// lock access to _inputDirty to avoid race conditions
-		boost::mutex::scoped_lock inputDirtyLock(_inputDirtyMutex);
+	// cached outputs were computed with the old internal state
+	_stateVersion++;
 
-		if (_inputDirty[i]) {
+	_modificationGeneration++;
 
-			PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " sending update signal to input " << i << std::endl;
+	sendModifiedSignal(outputNum, region);
+}
 
-			_inputDirty[i] = false;
+template <typename LockingStrategy>
+Region
+SimpleProcessNode<LockingStrategy>::getModifiedRegion(OutputBase& output) {
 
-			// release lock on _inputDirty, since the subsequent calls can cause 
-			// Modified signals to be sent to us, which will try to aquire the 
-			// lock as well
-			inputDirtyLock.unlock();
+	boost::mutex::scoped_lock lock(_regionMutex);
 
-			bool doItYourself = false;
+	return _outputModifiedRegion[_outputNums[&output]];
+}
 
-			if (numDirties <= 1) {
+template <typename LockingStrategy>
+bool
+SimpleProcessNode<LockingStrategy>::evictOutputs() {
 
-				doItYourself = true;
+	// don't release outputs that are currently computed
+	boost::unique_lock<boost::mutex> lock(_updateMutex, boost::try_to_lock);
 
-			} else {
+	if (!lock.owns_lock())
+		return false;
 
-				boost::mutex::scoped_lock lock(_threadCountMutex);
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " releasing outputs" << std::endl;
 
-				if (_numThreads == 0) {
+	setOutputsDirty();
 
-					PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " no more free threads available, will do it myself" << std::endl;
-					doItYourself = true;
+	{
+		boost::mutex::scoped_lock regionLock(_regionMutex);
 
-				} else {
+		for (int i = 0; i < _numOutputs; i++)
+			_outputModifiedRegion[i] = Region::everything();
+	}
 
-					_numThreads--;
+	for (int i = 0; i < _numOutputs; i++) {
 
-					PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " launching worker thread" << std::endl;
-					workers.create_thread(boost::ref(_inputUpdate[i]));
-				}
-			}
+		// Connected inputs might be read right now, they keep the data until 
+		// their process node releases it (see onInputModified() and 
+		// onMultiInputModified()).
+		getOutput(i).releaseData();
 
-			numDirties--;
+		// downstream process nodes have to update this output before reading 
+		// it again
+		Evicted signal;
+		_modified[i](signal);
+	}
 
-			if (doItYourself) {
+	return true;
+}
 
-				PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " asking for update myself" << std::endl;
-				_inputUpdate[i]();
-				PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " input " << i << " updated" << std::endl;
-			}
-		}
-	}
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::reportMemory(Profiler::time_type cost) {
 
-	// ask all dirty multi-inputs for updates
-	for (int i = 0; i < _numMultiInputs; i++) {
+	if (!_evictable || !MemoryManager::isEnabled())
+		return;
 
-		if (!multiInputOutputDepends(i, numOutput))
-			continue;
+	std::size_t size = 0;
 
-		for (unsigned int j = 0; j < _multiInputDirty[i].size(); j++) {
+	for (int i = 0; i < _numOutputs; i++)
+		if (boost::shared_ptr<Data> data = getOutput(i).getSharedDataPointer())
+			size += data->getSize();
 
-			// lock access to _multiInputDirty to avoid race conditions
-			boost::mutex::scoped_lock inputDirtyLock(_inputDirtyMutex);
+	boost::weak_ptr<ProcessNode> self;
 
-			if (_multiInputDirty[i][j]) {
+	try {
 
-				PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " sending update signal to multi-input " << i << ", input " << j << std::endl;
+		self = getSelfSharedPointer();
 
-				_multiInputDirty[i][j] = false;
+	} catch (boost::bad_weak_ptr&) {
 
-				// release lock on _inputDirty, since the subsequent calls can 
-				// cause Modified signals to be sent to us, which will try to 
-				// aquire the lock as well
-				inputDirtyLock.unlock();
+		LOG_ERROR(simpleprocessnodelog) << getLogPrefix() << " evictable process nodes have to be owned by a shared pointer" << std::endl;
+		_evictable = false;
+		return;
+	}
 
-				bool doItYourself = false;
+	MemoryManager::getInstance().update(this, self, size, cost);
+}
 
-				if (numDirties <= 1) {
+template <typename LockingStrategy>
+Region
+SimpleProcessNode<LockingStrategy>::getSignalRegion(const Modified& signal) {
 
-					doItYourself = true;
+	const RegionModified* regionModified = dynamic_cast<const RegionModified*>(&signal);
 
-				} else {
+	return (regionModified ? regionModified->getRegion() : Region::everything());
+}
 
-					boost::mutex::scoped_lock lock(_threadCountMutex);
+template <typename LockingStrategy>
+Region
+SimpleProcessNode<LockingStrategy>::getSignalRegion(const Update& signal) {
 
-					if (_numThreads == 0) {
+	const RegionUpdate* regionUpdate = dynamic_cast<const RegionUpdate*>(&signal);
 
-						PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " no more free threads available, will do it myself" << std::endl;
-						doItYourself = true;
+	return (regionUpdate ? regionUpdate->getRegion() : Region::everything());
+}
 
-					} else {
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::finishRegions(const Region& requested) {
 
-						_numThreads--;
+	bool partial = false;
 
-						PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " launching worker thread" << std::endl;
-						workers.create_thread(boost::ref((*_multiInputUpdates[i])[j]));
-					}
-				}
+	{
+		boost::mutex::scoped_lock lock(_regionMutex);
 
-				numDirties--;
+		for (int i = 0; i < _numOutputs; i++) {
 
-				if (doItYourself) {
+			if (requested.contains(_outputModifiedRegion[i]))
+				_outputModifiedRegion[i] = Region();
+			else
+				partial = true;
 
-					PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " asking for update myself" << std::endl;
-					(*_multiInputUpdates[i])[j]();
-					PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " multi-input " << i << ", input " << j << " updated" << std::endl;
-				}
-			}
+			_outputRequestedRegion[i] = Region();
 		}
 	}
 
-	if (workers.size() > 0) {
+	if (!partial)
+		return;
 
-		PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " waiting for all workers to finish..." << std::endl;
-		workers.join_all();
-		PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " workers finished" << std::endl;
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " outputs have been updated partially" << std::endl;
 
-		boost::mutex::scoped_lock lock(_threadCountMutex);
+	// the remaining modified region has to be updated the next time, 
+	// including the inputs
+	setOutputsDirty();
 
-		_numThreads += workers.size();
-	}
+	_inputDirty.setAll(true);
+	for (int i = 0; i < _numMultiInputs; i++)
+		_multiInputDirty[i]->setAll(true);
 }
 
 template <typename LockingStrategy>
 void
-SimpleProcessNode<LockingStrategy>::sendModifiedSignals(int numInput, int numMultiInput) {
+SimpleProcessNode<LockingStrategy>::setOutputCacheSize(unsigned int size) {
 
-	// first, check if the user has set an input-output dirty mapping and use 
-	// it, if present
+	boost::mutex::scoped_lock lock(_updateMutex);
 
-	if (numMultiInput == -1) {
+	_outputCacheSize = size;
 
-		if (_inputDirtys[numInput].size() > 0) {
+	while (_outputCache.size() > _outputCacheSize)
+		_outputCache.pop_back();
+}
 
-			foreach (int i, _inputDirtys[numInput])
-				_modified[i]();
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::onInputModified(const Modified& signal, int numInput) {
 
-			return;
-		}
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " input " << numInput << " was modified" << std::endl;
 
-	} else {
+	_inputDirty.set(numInput);
 
-		if (_multiInputDirtys[numMultiInput].size() > 0) {
+	// the content of evicted inputs did not change, it only has to be 
+	// recomputed before we read it the next time
+	if (signal.isEvicted()) {
 
-			foreach (int i, _multiInputDirtys[numMultiInput])
-				_modified[i]();
+		// release the evicted data, unless we are reading it right now (the 
+		// next update sets new data anyway)
+		boost::unique_lock<boost::mutex> lock(_updateMutex, boost::try_to_lock);
 
-			return;
-		}
+		if (lock.owns_lock())
+			getInput(numInput).releaseData();
+
+		return;
 	}
 
-	// otherwise, send modified to all outputs
-	for (int i = 0; i < _numOutputs; i++)
-		_modified[i]();
+	_modificationGeneration++;
+
+	sendModifiedSignals(numInput, -1, getSignalRegion(signal));
 }
 
 template <typename LockingStrategy>
-bool
-SimpleProcessNode<LockingStrategy>::haveDirtyInput() {
+void
+SimpleProcessNode<LockingStrategy>::onInputSet(const InputSetBase& /*signal*/, int numInput) {
 
-	// check inputs
-	for (int i = 0; i < _numInputs; i++)
-		if (_inputDirty[i])
-			return true;
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " input " << numInput << " got a new input" << std::endl;
 
-	// check multi-inputs
-	for (int i = 0; i < _numMultiInputs; i++)
-		for (unsigned int j = 0; j < _multiInputDirty[i].size(); j++)
-			if (_multiInputDirty[i][j])
-				return true;
+	_inputDirty.set(numInput);
 
-	return false;
+	_modificationGeneration++;
+
+	// since InputSet* signals are modified signals, we have to treat them as 
+	// such as well and propagate the Modified signal
+	sendModifiedSignals(numInput);
 }
 
 template <typename LockingStrategy>
-unsigned int
-SimpleProcessNode<LockingStrategy>::numDirtyInputs() {
+void
+SimpleProcessNode<LockingStrategy>::onInputSetToSharedPointer(const InputSetToSharedPointerBase& /*signal*/, int numInput) {
 
-	unsigned int numDirties = 0;
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " input " << numInput << " got a new input (shared pointer)" << std::endl;
 
-	// check inputs
-	for (int i = 0; i < _numInputs; i++)
-		if (_inputDirty[i])
-			numDirties++;
+	// shared pointer inputs are never dirty
+	_inputDirty.reset(numInput);
 
-	// check multi-inputs
-	for (int i = 0; i < _numMultiInputs; i++)
-		for (unsigned int j = 0; j < _multiInputDirty[i].size(); j++)
-			if (_multiInputDirty[i][j])
-				numDirties++;
+	// therefore, we have to set the outputs dirty explicitly
+	setOutputsDirty();
 
-	return numDirties;
+	_modificationGeneration++;
+
+	// shared pointers can't talk, so send the modified signal ourselves
+	sendModifiedSignals(numInput);
 }
 
 template <typename LockingStrategy>
-bool
-SimpleProcessNode<LockingStrategy>::haveDirtyOutput() {
+void
+SimpleProcessNode<LockingStrategy>::onInputAdded(const InputAddedBase& /*signal*/, int numMultiInput) {
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " multi-input " << numMultiInput << " got a new input" << std::endl;
+
+	// add a new dirty flag for this multi-input's new input
+	_multiInputDirty[numMultiInput]->push_back(true);
+
+	{
+		boost::mutex::scoped_lock lock(_changesMutex);
+		_pendingChanges[numMultiInput].setAdded(_multiInputDirty[numMultiInput]->size() - 1);
+	}
+
+	_modificationGeneration++;
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::onInputsCleared(const InputsCleared& /*signal*/, int numMultiInput) {
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " multi-input " << numMultiInput << " was cleared" << std::endl;
+
+	// don't release the slots while update signals are sent through them
+	boost::recursive_mutex::scoped_lock inputLock(_inputMutex);
+
+	// clear all flags for this multi-input
+	_multiInputDirty[numMultiInput]->clear();
+
+	// release the update slots of the cleared inputs
+	_multiInputUpdates[numMultiInput]->clear();
+
+	{
+		boost::mutex::scoped_lock lock(_changesMutex);
+		_pendingChanges[numMultiInput].setCleared();
+	}
+
+	_modificationGeneration++;
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::onMultiInputModified(const Modified& signal, int numInput, int numMultiInput) {
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " multi-input " << numMultiInput << " was modified in input " << numInput << std::endl;
+
+	_multiInputDirty[numMultiInput]->set(numInput);
+
+	// as in onInputModified(), evicted inputs did not change
+	if (signal.isEvicted()) {
+
+		boost::unique_lock<boost::mutex> lock(_updateMutex, boost::try_to_lock);
+
+		if (lock.owns_lock())
+			getMultiInput(numMultiInput).releaseData(numInput);
+
+		return;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(_changesMutex);
+		_pendingChanges[numMultiInput].setModified(numInput);
+	}
+
+	_modificationGeneration++;
+
+	sendModifiedSignals(numInput, numMultiInput, getSignalRegion(signal));
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::takeChanges() {
+
+	boost::mutex::scoped_lock lock(_changesMutex);
+
+	for (int i = 0; i < _numMultiInputs; i++) {
+
+		_multiInputChanges[i].merge(_pendingChanges[i]);
+		_pendingChanges[i].clear();
+	}
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::commitChanges() {
+
+	for (int i = 0; i < _numMultiInputs; i++)
+		_multiInputChanges[i].clear();
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::onUpdate(const Update& signal, int numOutput) {
+
+	ProfilingTimer waitTimer;
+
+	boost::mutex::scoped_lock lock(_updateMutex);
+
+	if (NodeStatistics* statistics = getStatistics())
+		statistics->updateMutexWaitTime += waitTimer.elapsed();
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " input update requested by another process node via output " << numOutput << std::endl;
+
+	// from now on, modifications have to be reported again to this output
+	_outputNotified.reset(numOutput);
+
+	{
+		boost::mutex::scoped_lock lock(_regionMutex);
+		_outputRequestedRegion[numOutput].unite(getSignalRegion(signal));
+	}
+
+	if (_evictable && MemoryManager::isEnabled())
+		MemoryManager::getInstance().used(this);
+
+	update(numOutput);
+}
+
+template <typename LockingStrategy>
+bool
+SimpleProcessNode<LockingStrategy>::needsUpdate() {
+
+	return haveDirtyInput() || haveDirtyOutput();
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::updateScheduled() {
+
+	ProfilingTimer waitTimer;
+
+	boost::mutex::scoped_lock lock(_updateMutex);
+
+	if (NodeStatistics* statistics = getStatistics())
+		statistics->updateMutexWaitTime += waitTimer.elapsed();
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " update requested by scheduler" << std::endl;
+
+	update(-1);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::updateScheduledBatch(const std::vector<ProcessNode*>& processNodes) {
+
+	std::vector<SimpleProcessNode*> instances;
+
+	foreach (ProcessNode* processNode, processNodes) {
+
+#ifndef NDEBUG
+		if (typeid(*processNode) != typeid(*this))
+			UTIL_THROW_EXCEPTION(
+					PipelineError,
+					"can not update " << typeName(*processNode) << " in a batch of " << typeName(*this));
+#endif
+
+		instances.push_back(static_cast<SimpleProcessNode*>(processNode));
+	}
+
+	// locked in the order of their addresses, such that concurrent batches 
+	// can not deadlock
+	std::sort(instances.begin(), instances.end());
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " batch update of " << instances.size() << " instances requested by scheduler" << std::endl;
+
+	// Update signals are sent upstream while holding only the update mutex of 
+	// the sending instance, as in separate updates. The upstream graph of one 
+	// instance might depend on another one, which would deadlock if all 
+	// update mutexes were held.
+	foreach (SimpleProcessNode* instance, instances) {
+
+		boost::mutex::scoped_lock lock(instance->_updateMutex);
+
+		instance->prepareInputs(-1);
+	}
+
+	std::vector<SimpleProcessNode*> separate;
+
+	{
+		std::vector<boost::shared_ptr<boost::mutex::scoped_lock> > locks;
+		foreach (SimpleProcessNode* instance, instances)
+			locks.push_back(boost::make_shared<boost::mutex::scoped_lock>(boost::ref(instance->_updateMutex)));
+
+		std::vector<SimpleProcessNode*>               updating;
+		std::vector<std::vector<boost::uint64_t> >    keys;
+		std::vector<boost::uint64_t>                  persistentKeys;
+
+		foreach (SimpleProcessNode* instance, instances) {
+
+			// the inputs changed since they were updated, which needs 
+			// another update signal -- not while holding all update mutexes
+			if (instance->haveDirtyInput()) {
+
+				separate.push_back(instance);
+				continue;
+			}
+
+			std::vector<boost::uint64_t> key;
+			boost::uint64_t              persistentKey = 0;
+
+			if (!instance->prepareOutputs(key, persistentKey))
+				continue;
+
+			updating.push_back(instance);
+			keys.push_back(key);
+			persistentKeys.push_back(persistentKey);
+		}
+
+		if (!updating.empty()) {
+
+			ProfilingTimer timer;
+
+			foreach (SimpleProcessNode* instance, updating)
+				instance->_lockTimer = timer;
+
+			if (LockingStrategy::LocksAtOnce) {
+
+				updating[0]->lockBatchAtOnce(updating);
+
+			} else {
+
+				std::set<Data*> locked;
+				updating[0]->lockBatchInputs(updating, 0, 0, locked);
+			}
+
+			// the cost is shared by all updated instances
+			Profiler::time_type updateCost = timer.elapsed()/updating.size();
+
+			for (unsigned int k = 0; k < updating.size(); k++)
+				updating[k]->finishUpdate(keys[k], persistentKeys[k], updateCost);
+		}
+	}
+
+	foreach (SimpleProcessNode* instance, separate)
+		instance->updateScheduled();
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::update(int numOutput) {
+
+	std::vector<boost::uint64_t> key;
+	boost::uint64_t              persistentKey = 0;
+
+	if (!prepareUpdate(numOutput, key, persistentKey))
+		return;
+
+	// lock inputs, outputs, and update outputs
+	_lockTimer = ProfilingTimer();
+	lockInputsOnDomain();
+
+	finishUpdate(key, persistentKey, _lockTimer.elapsed());
+}
+
+template <typename LockingStrategy>
+bool
+SimpleProcessNode<LockingStrategy>::prepareUpdate(int numOutput, std::vector<boost::uint64_t>& key, boost::uint64_t& persistentKey) {
+
+	prepareInputs(numOutput);
+
+	return prepareOutputs(key, persistentKey);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::prepareInputs(int numOutput) {
+
+	beginUpdate();
+
+	// changes received from now on might not be seen by the input updates,
+	// they are left for the next update
+	takeChanges();
+
+	// All outputs are updated at once, therefore all pending requests will be 
+	// answered. Updates without requests (e.g., by the scheduler) compute 
+	// everything.
+	{
+		boost::mutex::scoped_lock lock(_regionMutex);
+
+		_requestedRegion = Region();
+		for (int i = 0; i < _numOutputs; i++)
+			_requestedRegion.unite(_outputRequestedRegion[i]);
+
+		if (_requestedRegion.isEmpty())
+			_requestedRegion = Region::everything();
+	}
+
+	if (haveDirtyInput()) {
+
+		// our inputs changed -- need to recompute the output
+		setOutputsDirty();
+
+		PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " I have some dirty inputs -- sending update signals" << std::endl;
+
+		Region required = getRequiredRegion(_requestedRegion);
+
+		if (_fuseChains)
+			updateFusedChain(numOutput, required);
+
+		sendUpdateSignals(numOutput, required);
+	}
+}
+
+template <typename LockingStrategy>
+bool
+SimpleProcessNode<LockingStrategy>::prepareOutputs(std::vector<boost::uint64_t>& key, boost::uint64_t& persistentKey) {
+
+	/* Here a race condition can occur: While we are sending the update signals
+	 * to the inputs, a Modified signal might have been sent by another thread,
+	 * resulting in a dirty input right after the update. This is okay, since we
+	 * also send Modified to the next node. But with the following code, we set
+	 * _outputDirty to false and thus overwrote the setting of the Modified
+	 * signal we received earlier. The result is that we don't update our
+	 * output, since we don't know that it is dirty.
+	 *
+	 * One solution would be to set _outputDirty to true whenever we enter this
+	 * function and haveDirtyInput() is true. In this case, do we need
+	 * _outputDirty at all? Yes, the user can set the output dirty even if the
+	 * inputs didn't change.
+	 */
+
+	if (haveDirtyOutput() && requiredInputsPresent()) {
+
+		/* Here, the setDirty() race condition can occur. However, it won't hurt
+		 * since we are about to update the outputs anyway.
+		 */
+
+		// the inputs changed while we were updating them, our outputs stay 
+		// dirty
+		if (abandonUpdate()) {
+
+			PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " update was superseded -- skipping it" << std::endl;
+			return false;
+		}
+
+		setOutputsDirty(false);
+
+		if (_outputCacheSize > 0) {
+
+			getCacheKey(key);
+
+			if (restoreOutputs(key)) {
+
+				PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " inputs match a cached output set -- skipping update" << std::endl;
+
+				if (NodeStatistics* statistics = getStatistics())
+					statistics->numCacheHits++;
+
+				finishRegions(Region::everything());
+
+				reportMemory(0);
+
+				return false;
+			}
+		}
+
+		if (PersistentCache::isEnabled()) {
+
+			persistentKey = getPersistentKey();
+
+			if (persistentKey != 0 && loadPersistentOutputs(persistentKey)) {
+
+				PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " outputs restored from the persistent cache -- skipping update" << std::endl;
+
+				if (NodeStatistics* statistics = getStatistics())
+					statistics->numCacheHits++;
+
+				finishRegions(Region::everything());
+
+				reportMemory(0);
+
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	if (!requiredInputsPresent()) {
+
+		LOG_ERROR(simpleprocessnodelog) << getLogPrefix() << " asking for update, but not all required inputs are present!" << std::endl;
+	}
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " outputs are still up-to-date" << std::endl;
+
+	if (NodeStatistics* statistics = getStatistics())
+		statistics->numUpToDate++;
+
+	if (requiredInputsPresent())
+		finishRegions(_requestedRegion);
+
+	return false;
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::finishUpdate(const std::vector<boost::uint64_t>& key, boost::uint64_t persistentKey, Profiler::time_type updateCost) {
+
+	// the content of our outputs changed
+	for (int i = 0; i < _numOutputs; i++)
+		if (getOutput(i).getSharedDataPointer())
+			getOutput(i).getSharedDataPointer()->touch();
+
+	// a cancelled update might have returned early, partial updates are not 
+	// cached
+	if (_outputCacheSize > 0 && !isCancelled() && _requestedRegion.isEverything())
+		cacheOutputs(key);
+
+	if (persistentKey != 0 && !isCancelled() && _requestedRegion.isEverything())
+		storePersistentOutputs(persistentKey);
+
+	if (!isCancelled())
+		finishRegions(_requestedRegion);
+
+	reportMemory(updateCost);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::lockAtOnce() {
+
+	for (int i = 0; i < _numInputs; i++)
+		if (getInput(i).hasAssignedOutput())
+			_dataLocks.addShared(getInput(i).getSharedDataPointer());
+
+	// holding the data ensures that it survives, even if the owning Output 
+	// decides to replace it
+	for (int i = 0; i < _numOutputs; i++)
+		_dataLocks.addUnique(getOutput(i).getSharedDataPointer());
+
+	if (LockingStrategy::BacksOff)
+		_dataLocks.lockWithBackoff();
+	else
+		_dataLocks.lock();
+
+	try {
+
+		callUpdateOutputs();
+
+	} catch (...) {
+
+		_dataLocks.unlock();
+		throw;
+	}
+
+	_dataLocks.unlock();
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::lockInputsOnDomain() {
+
+	ThreadPool& pool = ThreadPool::getInstance();
+
+	int domain = (pool.getNumDomains() > 0 ? getUpdateDomain(pool) : -1);
+
+	if (domain < 0 || domain == pool.getCurrentDomain()) {
+
+		lockInputs(0);
+		return;
+	}
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " moving update to domain " << domain << std::endl;
+
+	// the update mutex stays locked by us, the worker only computes the 
+	// outputs
+	TaskGroup group;
+	group.run(boost::bind(&SimpleProcessNode<LockingStrategy>::lockInputs, this, 0), domain);
+	group.wait();
+}
+
+template <typename LockingStrategy>
+int
+SimpleProcessNode<LockingStrategy>::getUpdateDomain(ThreadPool& pool) {
+
+	if (_affinity != InputDomain)
+		return pool.checkDomain(_affinity);
+
+	std::vector<double> votes(pool.getNumDomains(), 0.0);
+
+	{
+		boost::recursive_mutex::scoped_lock lock(_inputMutex);
+
+		for (int i = 0; i < _numInputs; i++)
+			if (getInput(i).hasAssignedOutput())
+				voteDomain(votes, getInput(i).getAssignedOutput(), getInput(i).getSharedDataPointer());
+
+		for (int i = 0; i < _numMultiInputs; i++) {
+
+			MultiInput& multiInput = getMultiInput(i);
+
+			for (unsigned int j = 0; j < multiInput.size(); j++)
+				if (OutputBase* output = multiInput.getAssignedOutput(j))
+					voteDomain(votes, *output, multiInput.getSharedDataPointer(j));
+		}
+	}
+
+	int    domain = -1;
+	double best   = 0;
+
+	for (unsigned int d = 0; d < votes.size(); d++)
+		if (votes[d] > best) {
+
+			best   = votes[d];
+			domain = d;
+		}
+
+	return pool.checkDomain(domain);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::voteDomain(std::vector<double>& votes, OutputBase& output, boost::shared_ptr<Data> data) {
+
+	int domain = output.getDomain();
+
+	if (domain < 0 || domain >= static_cast<int>(votes.size()))
+		return;
+
+	// data of unknown size gets the smallest weight
+	votes[domain] += std::max(static_cast<double>(data ? data->getSize() : 0), 1.0);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::callUpdateOutputs() {
+
+	// remember where the output data was computed, such that downstream 
+	// process nodes can follow it
+	int domain = ThreadPool::getInstance().getCurrentDomain();
+
+	for (int i = 0; i < _numOutputs; i++)
+		getOutput(i).setDomain(domain);
+
+	NodeStatistics* statistics = getStatistics();
+
+	if (!statistics) {
+
+		updateOutputs();
+		commitChanges();
+		return;
+	}
+
+	statistics->lockWaitTime += _lockTimer.elapsed();
+
+	Profiler::time_type begin = Profiler::now();
+
+	updateOutputs();
+	commitChanges();
+
+	Profiler::time_type end = Profiler::now();
+
+	statistics->updateTime += end - begin;
+	statistics->numUpdates++;
+
+	addMeasuredCost(end - begin);
+
+	Profiler::getInstance().addTraceEvent(statistics->name, begin, end);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::lockBatchAtOnce(const std::vector<SimpleProcessNode*>& instances) {
+
+	foreach (SimpleProcessNode* instance, instances) {
+
+		for (int i = 0; i < instance->_numInputs; i++)
+			if (instance->getInput(i).hasAssignedOutput())
+				_dataLocks.addShared(instance->getInput(i).getSharedDataPointer());
+
+		for (int i = 0; i < instance->_numOutputs; i++)
+			_dataLocks.addUnique(instance->getOutput(i).getSharedDataPointer());
+	}
+
+	if (LockingStrategy::BacksOff)
+		_dataLocks.lockWithBackoff();
+	else
+		_dataLocks.lock();
+
+	try {
+
+		callUpdateOutputsBatch(instances);
+
+	} catch (...) {
+
+		_dataLocks.unlock();
+		throw;
+	}
+
+	_dataLocks.unlock();
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::lockBatchInputs(const std::vector<SimpleProcessNode*>& instances, unsigned int k, int i, std::set<Data*>& locked) {
+
+	if (k == instances.size()) {
+
+		callUpdateOutputsBatch(instances);
+		return;
+	}
+
+	SimpleProcessNode& instance = *instances[k];
+
+	if (i == instance._numInputs) {
+
+		lockBatchOutputs(instances, k, 0, locked);
+		return;
+	}
+
+	InputBase& input = instance.getInput(i);
+
+	// instances sharing an input data lock it only once
+	Data* data = input.getSharedDataPointer().get();
+
+	if (data && !locked.insert(data).second) {
+
+		lockBatchInputs(instances, k, i + 1, locked);
+		return;
+	}
+
+	instance.LockingStrategy::lockInput(
+			input,
+			boost::bind(&SimpleProcessNode::lockBatchInputs, this, boost::cref(instances), k, i + 1, boost::ref(locked)));
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::lockBatchOutputs(const std::vector<SimpleProcessNode*>& instances, unsigned int k, int i, std::set<Data*>& locked) {
+
+	SimpleProcessNode& instance = *instances[k];
+
+	if (i == instance._numOutputs) {
+
+		lockBatchInputs(instances, k + 1, 0, locked);
+		return;
+	}
+
+	instance.LockingStrategy::lockOutput(
+			instance.getOutput(i),
+			boost::bind(&SimpleProcessNode::lockBatchOutputs, this, boost::cref(instances), k, i + 1, boost::ref(locked)));
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::callUpdateOutputsBatch(const std::vector<SimpleProcessNode*>& instances) {
+
+	int domain = ThreadPool::getInstance().getCurrentDomain();
+
+	foreach (SimpleProcessNode* instance, instances)
+		for (int i = 0; i < instance->_numOutputs; i++)
+			instance->getOutput(i).setDomain(domain);
+
+	if (!Profiler::isEnabled()) {
+
+		updateOutputsBatch(instances);
+
+		foreach (SimpleProcessNode* instance, instances)
+			instance->commitChanges();
+
+		return;
+	}
+
+	// all instances started locking together
+	Profiler::time_type lockWaitTime = _lockTimer.elapsed();
+
+	Profiler::time_type begin = Profiler::now();
+
+	updateOutputsBatch(instances);
+
+	Profiler::time_type end = Profiler::now();
+
+	foreach (SimpleProcessNode* instance, instances) {
+
+		instance->commitChanges();
+
+		NodeStatistics* statistics = instance->getStatistics();
+
+		statistics->lockWaitTime += lockWaitTime;
+		statistics->updateTime   += (end - begin)/instances.size();
+		statistics->numUpdates++;
+
+		instance->addMeasuredCost((end - begin)/instances.size());
+	}
+
+	Profiler::getInstance().addTraceEvent(getStatistics()->name, begin, end);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::addMeasuredCost(Profiler::time_type cost) {
+
+	// only written under the update mutex
+	boost::uint64_t estimate = _estimatedCost;
+
+	_estimatedCost = (estimate == 0 ? cost : (3*estimate + cost)/4);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::updateOutputsBatch(const std::vector<SimpleProcessNode*>& instances) {
+
+	foreach (SimpleProcessNode* instance, instances)
+		instance->updateOutputs();
+}
+
+template <typename LockingStrategy>
+NodeStatistics*
+SimpleProcessNode<LockingStrategy>::getStatistics() {
+
+	if (!Profiler::isEnabled())
+		return 0;
+
+	// created here and not in the constructor, since the type name of the 
+	// derived class is not known there
+	if (!_statistics)
+		_statistics = Profiler::getInstance().createStatistics(typeName(*this) + (_name.size() ? std::string("(") + _name + ")" : ""));
+
+	return _statistics.get();
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::sendUpdateSignals(int numOutput, const Region& region) {
+
+	// Updates run against the topology of the current epoch, which stays 
+	// alive until they are done, and through slots that are kept alive by the 
+	// updates themselves. The input mutex is only held to collect them, such 
+	// that a concurrent rewiring of our inputs does not have to wait for the 
+	// update of the whole upstream graph.
+	boost::shared_ptr<const Topology>     topology;
+	std::vector<boost::function<void()> > updates;
+
+	{
+		boost::recursive_mutex::scoped_lock inputLock(_inputMutex);
+
+		// the topology is used with and without compiled dispatch, such that 
+		// all updates started here see the same connections
+		topology = getTopology();
+
+		// collect all dirty inputs
+		for (int i = 0; i < _numInputs; i++) {
+
+			if (!inputOutputDepends(i, numOutput))
+				continue;
+
+			// test and clear the dirty flag at once, such that a Modified signal 
+			// arriving during the update will not be lost
+			if (_inputDirty.reset(i)) {
+
+				PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " sending update signal to input " << i << std::endl;
+
+				const DirectUpdate* direct = (_compiledDispatch ? getDirectUpdate(*topology, i) : 0);
+
+				updates.push_back(boost::bind(&SimpleProcessNode<LockingStrategy>::sendUpdateSignal, this, &_inputUpdate[i], direct, boost::ref(_inputDirty), i, region));
+			}
+		}
+
+		// collect all dirty multi-inputs
+		for (int i = 0; i < _numMultiInputs; i++) {
+
+			if (!multiInputOutputDepends(i, numOutput))
+				continue;
+
+			for (unsigned int j = 0; j < _multiInputDirty[i]->size(); j++) {
+
+				if (_multiInputDirty[i]->reset(j)) {
+
+					PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " sending update signal to multi-input " << i << ", input " << j << std::endl;
+
+					const DirectUpdate* direct = (_compiledDispatch ? getDirectUpdate(*topology, i, j) : 0);
+
+					// the slot is created and connected the first time this 
+					// input gets updated through a signal
+					boost::shared_ptr<signals::Slot<Update> > slot;
+					if (!direct)
+						slot = _multiInputUpdates[i]->getSlot(j);
+
+					updates.push_back(boost::bind(&SimpleProcessNode<LockingStrategy>::sendLazyUpdateSignal, this, slot, direct, boost::ref(*_multiInputDirty[i]), j, region));
+				}
+			}
+		}
+	}
+
+	TaskGroup workers;
+
+	// ask the inputs for updates, the last one is always updated by ourselves
+	for (unsigned int k = 0; k < updates.size(); k++) {
+
+		if (k + 1 < updates.size() && workers.isParallel()) {
+
+			PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " submitting update to thread pool" << std::endl;
+			workers.run(updates[k]);
+
+			if (NodeStatistics* statistics = getStatistics())
+				statistics->numParallelUpdates++;
+
+		} else {
+
+			PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " asking for update myself" << std::endl;
+			updates[k]();
+		}
+	}
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " waiting for submitted updates to finish..." << std::endl;
+
+	// help executing our own updates that have not been picked up by a 
+	// worker
+	workers.wait();
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " all updates finished" << std::endl;
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::sendUpdateSignal(signals::Slot<Update>* slot, const DirectUpdate* direct, DirtyFlags& dirtyFlags, unsigned int i, const Region& region) {
+
+	if (abandonUpdate()) {
+
+		PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " update was superseded -- not updating input " << i << std::endl;
+
+		// leave the update of this input for the next time
+		dirtyFlags.set(i);
+		return;
+	}
+
+	RegionUpdate signal(region);
+
+	boost::shared_ptr<ProcessNode> upstream;
+	if (direct)
+		upstream = direct->processNode.lock();
+
+	if (upstream)
+		upstream->updateDirectly(signal, direct->numOutput);
+	else if (slot)
+		(*slot)(signal);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::sendLazyUpdateSignal(boost::shared_ptr<signals::Slot<Update> > slot, const DirectUpdate* direct, DirtyFlags& dirtyFlags, unsigned int i, const Region& region) {
+
+	sendUpdateSignal(slot.get(), direct, dirtyFlags, i, region);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::compileDispatch() {
+
+	boost::shared_ptr<Topology> topology = boost::make_shared<Topology>();
+
+	// changes after this point start a new epoch
+	topology->epoch = OutputBase::getConnectionEpoch();
+
+	for (int i = 0; i < _numInputs; i++)
+		topology->inputs.push_back(resolveDirectUpdate(getInput(i).hasAssignedOutput() ? &getInput(i).getAssignedOutput() : 0));
+
+	for (int i = 0; i < _numMultiInputs; i++) {
+
+		MultiInput& multiInput = getMultiInput(i);
+
+		topology->multiInputs.push_back(std::vector<DirectUpdate>());
+		topology->multiInputs.back().reserve(multiInput.size());
+
+		for (unsigned int j = 0; j < multiInput.size(); j++)
+			topology->multiInputs.back().push_back(resolveDirectUpdate(multiInput.getAssignedOutput(j)));
+	}
+
+	boost::atomic_store(&_topology, boost::shared_ptr<const Topology>(topology));
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " compiled dispatch for epoch " << topology->epoch << std::endl;
+}
+
+template <typename LockingStrategy>
+boost::shared_ptr<const typename SimpleProcessNode<LockingStrategy>::Topology>
+SimpleProcessNode<LockingStrategy>::getTopology() {
+
+	boost::shared_ptr<const Topology> topology = boost::atomic_load(&_topology);
+
+	if (!topology || topology->epoch != OutputBase::getConnectionEpoch()) {
+
+		compileDispatch();
+		topology = boost::atomic_load(&_topology);
+	}
+
+	return topology;
+}
+
+template <typename LockingStrategy>
+typename SimpleProcessNode<LockingStrategy>::DirectUpdate
+SimpleProcessNode<LockingStrategy>::resolveDirectUpdate(OutputBase* output) {
+
+	DirectUpdate direct;
+
+	if (!output)
+		return direct;
+
+	try {
+
+		std::vector<boost::shared_ptr<ProcessNode> > dependencies = output->getDependencies();
+
+		if (dependencies.size() != 1)
+			return direct;
+
+		int numOutput = dependencies[0]->getDirectUpdateOutput(*output);
+
+		if (numOutput < 0)
+			return direct;
+
+		direct.processNode = dependencies[0];
+		direct.output      = output;
+		direct.numOutput   = numOutput;
+
+	} catch (boost::bad_weak_ptr&) {
+
+		// process nodes not owned by a shared pointer keep using signals
+	}
+
+	return direct;
+}
+
+template <typename LockingStrategy>
+const typename SimpleProcessNode<LockingStrategy>::DirectUpdate*
+SimpleProcessNode<LockingStrategy>::getDirectUpdate(const Topology& topology, int numInput) {
+
+	if (numInput >= static_cast<int>(topology.inputs.size()))
+		return 0;
+
+	const DirectUpdate& direct = topology.inputs[numInput];
+
+	// the input might have been reassigned within the current epoch
+	if (direct.processNode.expired() || !getInput(numInput).hasAssignedOutput() || &getInput(numInput).getAssignedOutput() != direct.output)
+		return 0;
+
+	return &direct;
+}
+
+template <typename LockingStrategy>
+const typename SimpleProcessNode<LockingStrategy>::DirectUpdate*
+SimpleProcessNode<LockingStrategy>::getDirectUpdate(const Topology& topology, int numMultiInput, unsigned int i) {
+
+	if (numMultiInput >= static_cast<int>(topology.multiInputs.size()) || i >= topology.multiInputs[numMultiInput].size())
+		return 0;
+
+	const DirectUpdate& direct = topology.multiInputs[numMultiInput][i];
+
+	if (direct.processNode.expired() || getMultiInput(numMultiInput).getAssignedOutput(i) != direct.output)
+		return 0;
+
+	return &direct;
+}
+
+template <typename LockingStrategy>
+int
+SimpleProcessNode<LockingStrategy>::getDirectUpdateOutput(OutputBase& output) {
+
+	// other callbacks than our own have to receive the signal as well
+	if (output.getNumCallbacks() != 1)
+		return -1;
+
+	std::map<OutputBase*, unsigned int>::const_iterator i = _outputNums.find(&output);
+
+	if (i == _outputNums.end())
+		return -1;
+
+	return i->second;
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::updateDirectly(const Update& signal, int numOutput) {
+
+	onUpdate(signal, numOutput);
+}
+
+template <typename LockingStrategy>
+boost::shared_ptr<ProcessNode>
+SimpleProcessNode<LockingStrategy>::getFusedUpstream() {
+
+	boost::recursive_mutex::scoped_lock lock(_inputMutex);
+
+	if (_numInputs != 1 || _numMultiInputs != 0)
+		return boost::shared_ptr<ProcessNode>();
+
+	const DirectUpdate* direct = getDirectUpdate(*getTopology(), 0);
+
+	if (!direct)
+		return boost::shared_ptr<ProcessNode>();
+
+	// other consumers of the upstream output could pull it while the chain 
+	// is updated, and would see it clean although it is not computed, yet
+	if (direct->output->getNumConsumers() != 1)
+		return boost::shared_ptr<ProcessNode>();
+
+	return direct->processNode.lock();
+}
+
+template <typename LockingStrategy>
+bool
+SimpleProcessNode<LockingStrategy>::clearFusedInput() {
+
+	if (!_inputDirty.test(0))
+		return false;
+
+	// Called by the head of the chain, without our update mutex. Our outputs 
+	// are marked dirty before our input looks clean, such that an update 
+	// that does not come from the chain will still recompute them.
+	setOutputsDirty();
+
+	return _inputDirty.reset(0);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::updateFused(bool inputModified) {
+
+	// the fused chain consumed the dirty flag of our input
+	if (inputModified)
+		setOutputsDirty();
+
+	onUpdate(Update(), 0);
+}
+
+template <typename LockingStrategy>
+const std::vector<boost::shared_ptr<ProcessNode> >&
+SimpleProcessNode<LockingStrategy>::getFusedChain() {
+
+	unsigned int epoch = OutputBase::getConnectionEpoch();
+
+	if (_fusedCompiled && _fusedEpoch == epoch)
+		return _fusedChain;
+
+	_fusedEpoch    = epoch;
+	_fusedCompiled = true;
+
+	_fusedChain.clear();
+
+	std::set<ProcessNode*> members;
+	members.insert(this);
+
+	boost::shared_ptr<ProcessNode> upstream = getFusedUpstream();
+
+	while (upstream && upstream->isFusible() && members.insert(upstream.get()).second) {
+
+		_fusedChain.push_back(upstream);
+		upstream = upstream->getFusedUpstream();
+	}
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " fused a chain of " << _fusedChain.size() << " upstream process nodes" << std::endl;
+
+	return _fusedChain;
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::updateFusedChain(int numOutput, const Region& region) {
+
+	// partial updates need the required regions of each member
+	if (_numInputs != 1 || _numMultiInputs != 0 || !region.isEverything() || !inputOutputDepends(0, numOutput))
+		return;
+
+	const std::vector<boost::shared_ptr<ProcessNode> >& chain = getFusedChain();
+
+	if (chain.empty())
+		return;
+
+	// As in sendUpdateSignals(), the dirty flags are cleared before the 
+	// upstream members get updated, such that a Modified signal arriving 
+	// meanwhile will not be lost. The head keeps its flag and updates its 
+	// input itself.
+	if (!_inputDirty.reset(0))
+		return;
+
+	std::vector<bool> inputModified;
+
+	while (inputModified.size() < chain.size()) {
+
+		if (inputModified.size() + 1 == chain.size()) {
+
+			inputModified.push_back(false);
+			break;
+		}
+
+		inputModified.push_back(chain[inputModified.size()]->clearFusedInput());
+
+		// members further upstream are up-to-date
+		if (!inputModified.back())
+			break;
+	}
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " updating " << inputModified.size() << " members of the fused chain" << std::endl;
+
+	int j = inputModified.size() - 1;
+
+	try {
+
+		for (; j >= 0; j--) {
+
+			if (abandonUpdate())
+				break;
+
+			chain[j]->updateFused(inputModified[j]);
+		}
+
+	} catch (...) {
+
+		for (; j >= 0; j--)
+			if (inputModified[j])
+				chain[j]->setFusedInputDirty();
+
+		_inputDirty.set(0);
+
+		throw;
+	}
+
+	// a cancelled chain is continued by the next update
+	if (j >= 0) {
+
+		for (; j >= 0; j--)
+			if (inputModified[j])
+				chain[j]->setFusedInputDirty();
+
+		_inputDirty.set(0);
+	}
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::sendModifiedSignals(int numInput, int numMultiInput, const Region& inputRegion) {
+
+	Region region = (inputRegion.isEverything() ? inputRegion : getAffectedRegion(inputRegion));
+
+	// first, check if the user has set an input-output dirty mapping and use 
+	// it, if present
+
+	if (numMultiInput == -1) {
+
+		if (_inputDirtys[numInput].size() > 0) {
+
+			foreach (int i, _inputDirtys[numInput])
+				sendModifiedSignal(i, region);
+
+			return;
+		}
+
+	} else {
 
+		if (_multiInputDirtys[numMultiInput].size() > 0) {
+
+			foreach (int i, _multiInputDirtys[numMultiInput])
+				sendModifiedSignal(i, region);
+
+			return;
+		}
+	}
+
+	// otherwise, send modified to all outputs
 	for (int i = 0; i < _numOutputs; i++)
-		if (_outputDirty[i])
+		sendModifiedSignal(i, region);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::sendModifiedSignal(int numOutput, const Region& region) {
+
+	// a region outside of what we reported already has to be reported again
+	bool grown;
+
+	{
+		boost::mutex::scoped_lock lock(_regionMutex);
+
+		grown = !_outputModifiedRegion[numOutput].contains(region);
+		_outputModifiedRegion[numOutput].unite(region);
+	}
+
+	// the output is out of date, even if the signal is coalesced
+	if (_prefetch)
+		schedulePrefetch();
+
+	// Remember that we informed the downstream nodes. As long as they did not 
+	// ask for an update of this output, they know already that it is 
+	// modified. Therefore, further Modified signals can be skipped.
+	if (_outputNotified.set(numOutput) && _coalesceModified && !grown) {
+
+		PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " output " << numOutput << " was reported modified already" << std::endl;
+		return;
+	}
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " sending modified to output " << numOutput << std::endl;
+
+	RegionModified signal(region);
+	_modified[numOutput](signal);
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::schedulePrefetch() {
+
+	if (_prefetchScheduled.exchange(true))
+		return;
+
+	boost::weak_ptr<ProcessNode> self;
+
+	try {
+
+		self = getSelfSharedPointer();
+
+	} catch (boost::bad_weak_ptr&) {
+
+		LOG_ERROR(simpleprocessnodelog) << getLogPrefix() << " prefetching process nodes have to be owned by a shared pointer" << std::endl;
+		_prefetch = false;
+		_prefetchScheduled = false;
+		return;
+	}
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " scheduling prefetch" << std::endl;
+
+	if (!ThreadPool::getInstance().scheduleIdle(boost::bind(&SimpleProcessNode<LockingStrategy>::prefetch, this, self)))
+		_prefetchScheduled = false;
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::prefetch(SimpleProcessNode* processNode, boost::weak_ptr<ProcessNode> self) {
+
+	// keep the process node alive during the update, but don't prevent its 
+	// destruction while the prefetch is queued
+	boost::shared_ptr<ProcessNode> alive = self.lock();
+
+	if (!alive)
+		return;
+
+	// Modified signals from now on schedule another prefetch
+	processNode->_prefetchScheduled = false;
+
+	boost::mutex::scoped_lock lock(processNode->_updateMutex);
+
+	// somebody else updated in the meantime
+	if (!processNode->needsUpdate())
+		return;
+
+	PIPELINE_LOG_ALL(simpleprocessnodelog) << processNode->getLogPrefix() << " prefetching outputs" << std::endl;
+
+	processNode->_speculative = true;
+
+	try {
+
+		processNode->update(-1);
+
+	} catch (...) {
+
+		// the next update request will fail as well and report the error
+		PIPELINE_LOG_ALL(simpleprocessnodelog)
+				<< processNode->getLogPrefix() << " prefetch failed: "
+				<< boost::current_exception_diagnostic_information() << std::endl;
+	}
+
+	processNode->_speculative = false;
+}
+
+template <typename LockingStrategy>
+bool
+SimpleProcessNode<LockingStrategy>::haveDirtyInput() {
+
+	// check inputs
+	if (_inputDirty.any())
+		return true;
+
+	// check multi-inputs
+	for (int i = 0; i < _numMultiInputs; i++)
+		if (_multiInputDirty[i]->any())
 			return true;
 
 	return false;
 }
 
+template <typename LockingStrategy>
+unsigned int
+SimpleProcessNode<LockingStrategy>::numDirtyInputs() {
+
+	// check inputs
+	unsigned int numDirties = _inputDirty.count();
+
+	// check multi-inputs
+	for (int i = 0; i < _numMultiInputs; i++)
+		numDirties += _multiInputDirty[i]->count();
+
+	return numDirties;
+}
+
+template <typename LockingStrategy>
+bool
+SimpleProcessNode<LockingStrategy>::haveDirtyOutput() {
+
+	return _outputDirty.any();
+}
+
 template <typename LockingStrategy>
 void
 SimpleProcessNode<LockingStrategy>::setOutputsDirty(bool dirty) {
 
-	for (unsigned int i = 0; i < _outputDirty.size(); i++)
-		_outputDirty[i] = dirty;
+	_outputDirty.setAll(dirty);
 }
 
 template <typename LockingStrategy>
@@ -651,10 +2024,245 @@ SimpleProcessNode<LockingStrategy>::multiInputOutputDepends(int numMultiInput, i
 	return false;
 }
 
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::getCacheKey(std::vector<boost::uint64_t>& key) {
+
+	key.push_back(_stateVersion);
+
+	// absent data has version 0
+	for (int i = 0; i < _numInputs; i++) {
+
+		boost::shared_ptr<Data> data = getInput(i).getSharedDataPointer();
+		key.push_back(data ? data->getVersion() : 0);
+	}
+
+	for (int i = 0; i < _numMultiInputs; i++) {
+
+		MultiInput& multiInput = getMultiInput(i);
+
+		// the number of entries separates the versions of different 
+		// multi-inputs
+		key.push_back(multiInput.size());
+
+		for (unsigned int j = 0; j < multiInput.size(); j++) {
+
+			boost::shared_ptr<Data> data = multiInput.getSharedDataPointer(j);
+			key.push_back(data ? data->getVersion() : 0);
+		}
+	}
+}
+
+template <typename LockingStrategy>
+boost::uint64_t
+SimpleProcessNode<LockingStrategy>::getPersistentKey() {
+
+	// all outputs have to be persistent to skip the update
+	if (_numOutputs == 0)
+		return 0;
+
+	foreach (boost::shared_ptr<PersistentOutputBase> output, _persistentOutputs)
+		if (!output)
+			return 0;
+
+	// the assigned outputs and the data of all inputs, in the order they 
+	// are added to the key
+	std::vector<std::pair<OutputBase*, boost::shared_ptr<Data> > > inputs;
+	std::vector<unsigned int> multiInputSizes;
+
+	for (int i = 0; i < _numInputs; i++) {
+
+		InputBase& input = getInput(i);
+
+		inputs.push_back(std::make_pair(input.hasAssignedOutput() ? &input.getAssignedOutput() : static_cast<OutputBase*>(0), input.getSharedDataPointer()));
+	}
+
+	for (int i = 0; i < _numMultiInputs; i++) {
+
+		MultiInput& multiInput = getMultiInput(i);
+
+		unsigned int size = multiInput.size();
+
+		multiInputSizes.push_back(size);
+
+		for (unsigned int j = 0; j < size; j++)
+			inputs.push_back(std::make_pair(multiInput.getAssignedOutput(j), multiInput.getSharedDataPointer(j)));
+	}
+
+	// content keys might be computed from the content of the inputs
+	DataLocks locks;
+
+	for (unsigned int i = 0; i < inputs.size(); i++)
+		locks.addShared(inputs[i].second);
+
+	locks.lock();
+
+	ContentHash hash;
+
+	hash.add(typeName(*this));
+
+	writeParameters(hash);
+
+	unsigned int next = 0;
+
+	for (int i = 0; i < _numInputs; i++, next++)
+		if (!addContentKey(hash, inputs[next].first, inputs[next].second))
+			return 0;
+
+	for (int i = 0; i < _numMultiInputs; i++) {
+
+		hash.add(static_cast<boost::uint64_t>(multiInputSizes[i]));
+
+		for (unsigned int j = 0; j < multiInputSizes[i]; j++, next++)
+			if (!addContentKey(hash, inputs[next].first, inputs[next].second))
+				return 0;
+	}
+
+	return hash.get();
+}
+
+template <typename LockingStrategy>
+bool
+SimpleProcessNode<LockingStrategy>::addContentKey(ContentHash& hash, OutputBase* output, boost::shared_ptr<Data> data) {
+
+	// absent optional inputs are part of the key
+	if (!data) {
+
+		hash.add(static_cast<boost::uint64_t>(0));
+		return true;
+	}
+
+	boost::uint64_t key = (output ? output->getContentKey(*data) : data->getContentKey());
+
+	if (key == 0)
+		return false;
+
+	hash.add(key);
+
+	return true;
+}
+
+template <typename LockingStrategy>
+bool
+SimpleProcessNode<LockingStrategy>::loadPersistentOutputs(boost::uint64_t key) {
+
+	PersistentCache& cache = PersistentCache::getInstance();
+
+	std::vector<boost::shared_ptr<const void> > mappings(_numOutputs);
+	std::vector<const char*>                    buffers(_numOutputs);
+	std::vector<std::size_t>                    sizes(_numOutputs);
+
+	// assign only if all outputs are present
+	for (int i = 0; i < _numOutputs; i++)
+		if (!cache.load(key, i, mappings[i], buffers[i], sizes[i]))
+			return false;
+
+	for (int i = 0; i < _numOutputs; i++) {
+
+		_persistentOutputs[i]->assign(buffers[i], sizes[i], mappings[i]);
+
+		if (boost::shared_ptr<Data> data = getOutput(i).getSharedDataPointer())
+			data->setContentKey(getOutputKey(key, i));
+	}
+
+	return true;
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::storePersistentOutputs(boost::uint64_t key) {
+
+	for (int i = 0; i < _numOutputs; i++) {
+
+		_persistentOutputs[i]->store(key, i);
+
+		// downstream process nodes can use the same key in the next run
+		if (boost::shared_ptr<Data> data = getOutput(i).getSharedDataPointer())
+			data->setContentKey(getOutputKey(key, i));
+	}
+}
+
+template <typename LockingStrategy>
+boost::uint64_t
+SimpleProcessNode<LockingStrategy>::getOutputKey(boost::uint64_t key, unsigned int num) {
+
+	ContentHash hash;
+
+	hash.add(key);
+	hash.add(static_cast<boost::uint64_t>(num));
+
+	return hash.get();
+}
+
+template <typename LockingStrategy>
+bool
+SimpleProcessNode<LockingStrategy>::restoreOutputs(const std::vector<boost::uint64_t>& key) {
+
+	typename std::list<CacheEntry>::iterator entry = _outputCache.begin();
+
+	while (entry != _outputCache.end()) {
+
+		if (entry->key != key) {
+
+			entry++;
+			continue;
+		}
+
+		// the cached data might have been changed in place since (e.g., 
+		// because it is the data of the current outputs)
+		bool valid = true;
+		for (int i = 0; i < _numOutputs; i++)
+			if (entry->outputs[i] && entry->outputs[i]->getVersion() != entry->versions[i])
+				valid = false;
+
+		if (!valid) {
+
+			PIPELINE_LOG_ALL(simpleprocessnodelog) << getLogPrefix() << " cached output set is outdated" << std::endl;
+
+			_outputCache.erase(entry);
+			return false;
+		}
+
+		for (int i = 0; i < _numOutputs; i++)
+			if (getOutput(i).getSharedDataPointer() != entry->outputs[i])
+				getOutput(i).setSharedDataPointer(entry->outputs[i]);
+
+		// most recently used first
+		_outputCache.splice(_outputCache.begin(), _outputCache, entry);
+
+		return true;
+	}
+
+	return false;
+}
+
+template <typename LockingStrategy>
+void
+SimpleProcessNode<LockingStrategy>::cacheOutputs(const std::vector<boost::uint64_t>& key) {
+
+	_outputCache.push_front(CacheEntry());
+
+	CacheEntry& entry = _outputCache.front();
+	entry.key = key;
+
+	for (int i = 0; i < _numOutputs; i++) {
+
+		boost::shared_ptr<Data> data = getOutput(i).getSharedDataPointer();
+
+		entry.outputs.push_back(data);
+		entry.versions.push_back(data ? data->getVersion() : 0);
+	}
+
+	while (_outputCache.size() > _outputCacheSize)
+		_outputCache.pop_back();
+}
+
 // compile these specializations
 template class SimpleProcessNode<FullLockingStrategy>;
 template class SimpleProcessNode<InputLockingStrategy>;
 template class SimpleProcessNode<OutputLockingStrategy>;
 template class SimpleProcessNode<NoLockingStrategy>;
+template class SimpleProcessNode<DoubleBufferedLockingStrategy>;
+template class SimpleProcessNode<BackoffLockingStrategy>;
 
 }
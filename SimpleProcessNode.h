@@ -1,18 +1,38 @@
 #ifndef PIPELINE_SIMPLE_PROCESS_NODE_H__
 #define PIPELINE_SIMPLE_PROCESS_NODE_H__
 
+#include <list>
+#include <set>
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/thread/future.hpp>
 #include <boost/thread/thread.hpp>
 #include <boost/thread/mutex.hpp>
-#include <boost/bind.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/weak_ptr.hpp>
 
 #include <signals/Slot.h>
 #include <signals/Slots.h>
+#include <util/typename.h>
 #include <pipeline/signals/all.h>
 #include <pipeline/Data.h>
+#include <pipeline/DataLocks.h>
+#include <pipeline/DirtyFlags.h>
 #include <pipeline/Input.h>
 #include <pipeline/Inputs.h>
+#include <pipeline/LazySlots.h>
+#include <pipeline/MemoryManager.h>
+#include <pipeline/MultiInputChanges.h>
 #include <pipeline/Output.h>
+#include <pipeline/PersistentCache.h>
+#include <pipeline/Ports.h>
 #include <pipeline/ProcessNode.h>
+#include <pipeline/Profiling.h>
+#include <pipeline/Region.h>
+#include <pipeline/ThreadPool.h>
 
 namespace pipeline {
 
@@ -30,6 +50,13 @@ class NoLockingStrategy {
 
 public:
 
+	// strategies that set this lock the data of all inputs and outputs at 
+	// once in address order, instead of calling lockInput() and lockOutput()
+	static const bool LocksAtOnce = false;
+
+	// acquire the locks at once with DataLocks::lockWithBackoff()
+	static const bool BacksOff = false;
+
 	void lockInput(InputBase&, boost::function<void()> next) {
 
 		next();
@@ -99,24 +126,181 @@ public:
  * Full input/output locking strategy. Safe, but potentially inefficient,
  * locking mechanism for output updates. Allocates read locks on all inputs and
  * write locks on all outputs before calling updateOutputs().
+ *
+ * The locks are collected first and acquired in one pass, sorted by the 
+ * address of the data (see DataLocks). Therefore, process nodes with this 
+ * strategy can not deadlock on data they share, and data that is an input 
+ * and an output at the same time is write locked only once.
  */
 class FullLockingStrategy : public InputLockingStrategy, public OutputLockingStrategy {
 
 public:
 
+	static const bool LocksAtOnce = true;
+
 	using InputLockingStrategy::lockInput;
 	using OutputLockingStrategy::lockOutput;
 };
 
+/**
+ * Like FullLockingStrategy, but does not hold any lock while waiting for 
+ * another one. If one of the locks is not available, all are released again 
+ * and acquired after a pause. Use this for process nodes with many inputs or 
+ * outputs that are contended, such that they don't block others while 
+ * waiting.
+ */
+class BackoffLockingStrategy : public FullLockingStrategy {
+
+public:
+
+	static const bool BacksOff = true;
+};
+
+/**
+ * Lock-free strategy for double buffered outputs. Outputs that enabled double 
+ * buffering are computed into a back buffer, which is published afterwards 
+ * with a single pointer swap. Published data is never written again, 
+ * therefore inputs assigned to double buffered outputs are not locked either 
+ * -- their data is pinned during the update instead (see 
+ * InputBase::pinData()), such that every access in updateOutputs() sees the 
+ * same buffer. All other inputs and outputs are locked as with the 
+ * FullLockingStrategy.
+ */
+class DoubleBufferedLockingStrategy : public InputLockingStrategy, public OutputLockingStrategy {
+
+public:
+
+	void lockInput(InputBase& input, boost::function<void()> next) {
+
+		if (input.hasAssignedOutput() && input.getAssignedOutput().isDoubleBuffered()) {
+
+			// the input reads its data anew on every access, therefore a new 
+			// buffer published meanwhile must not be assigned to it before 
+			// the update is done
+			input.pinData();
+
+			try {
+
+				next();
+
+			} catch (...) {
+
+				input.unpinData();
+				throw;
+			}
+
+			input.unpinData();
+
+		} else {
+
+			InputLockingStrategy::lockInput(input, next);
+		}
+	}
+
+	void lockOutput(OutputBase& output, boost::function<void()> next) {
+
+		if (!output.isDoubleBuffered()) {
+
+			OutputLockingStrategy::lockOutput(output, next);
+			return;
+		}
+
+		output.beginBackBuffer();
+
+		try {
+
+			next();
+
+		} catch (...) {
+
+			output.discardBackBuffer();
+			throw;
+		}
+
+		output.publishBackBuffer();
+	}
+};
+
 template <class LockingStrategy = FullLockingStrategy>
-class SimpleProcessNode : public LockingStrategy, public ProcessNode {
+class SimpleProcessNode : public LockingStrategy, public ProcessNode, public EvictableOutputs {
 
 public:
 
+	/**
+	 * Callback type for continuations of asynchronous updates. The argument is 
+	 * the exception thrown by the update, or empty on success.
+	 */
+	typedef boost::function<void(const boost::exception_ptr&)> continuation_type;
+
+	/**
+	 * Thrown, if a port is registered or accessed with a number or type that 
+	 * does not match its declaration.
+	 */
+	struct PortMismatch : virtual PipelineError {};
+
 	SimpleProcessNode(std::string name = "");
 
 	virtual ~SimpleProcessNode();
 
+	using ProcessNode::setInput;
+	using ProcessNode::addInput;
+	using ProcessNode::getInput;
+	using ProcessNode::getOutput;
+
+	/**
+	 * Connect an input port of this process node to an output. The data types 
+	 * are verified at compile time, the input is found by its number, and 
+	 * data set on the output will be forwarded without runtime type checks.
+	 *
+	 * @param Port   The InputPort declaration of the input.
+	 * @param output The output to connect to.
+	 */
+	template <typename Port, typename OutputDataType>
+	bool setInput(OutputImpl<OutputDataType>& output) {
+
+		return getInput<Port>().acceptTyped(output);
+	}
+
+	/**
+	 * Add an output to a multi-input port of this process node. See 
+	 * setInput<Port>().
+	 *
+	 * @param Port   The InputsPort declaration of the multi-input.
+	 * @param output The output to add.
+	 */
+	template <typename Port, typename OutputDataType>
+	bool addInput(OutputImpl<OutputDataType>& output) {
+
+		return getInputs<Port>().acceptTyped(output);
+	}
+
+	/**
+	 * Get an input of this process node by its port declaration.
+	 */
+	template <typename Port>
+	typename Port::port_type& getInput() {
+
+		return getPort<Port>(ProcessNode::getInput(Port::number));
+	}
+
+	/**
+	 * Get a multi-input of this process node by its port declaration.
+	 */
+	template <typename Port>
+	typename Port::port_type& getInputs() {
+
+		return getPort<Port>(ProcessNode::getMultiInput(Port::number));
+	}
+
+	/**
+	 * Get an output of this process node by its port declaration.
+	 */
+	template <typename Port>
+	typename Port::port_type& getOutput() {
+
+		return getPort<Port>(ProcessNode::getOutput(Port::number));
+	}
+
 	const std::string& getName() { return _name; }
 
 	/**
@@ -128,7 +312,7 @@ public:
 	 */
 	void clearInputs(unsigned int i) {
 
-		boost::mutex::scoped_lock lock(_inputMutex);
+		boost::recursive_mutex::scoped_lock lock(_inputMutex);
 
 		ProcessNode::clearInputs(i);
 	}
@@ -142,11 +326,35 @@ public:
 	 */
 	void clearInputs(const std::string& name) {
 
-		boost::mutex::scoped_lock lock(_inputMutex);
+		boost::recursive_mutex::scoped_lock lock(_inputMutex);
 
 		ProcessNode::clearInputs(name);
 	}
 
+	/**
+	 * Special values for setAffinity().
+	 */
+	enum Affinity {
+
+		// update on any thread (the default)
+		AnyDomain = -1,
+
+		// update on the domain that computed most of the input data
+		InputDomain = -2
+	};
+
+	/**
+	 * Bind the updates of this process node to a NUMA domain of the thread 
+	 * pool (see program option 'numaDomains'). updateOutputs() will be called 
+	 * by a worker of this domain, such that the input data is read from local 
+	 * memory and new output data is allocated in local memory. Has no effect, 
+	 * if the domain does not exist.
+	 *
+	 * @param domain The number of the domain, AnyDomain, or InputDomain to 
+	 *               follow the input data, weighted by Data::getSize().
+	 */
+	void setAffinity(int domain) { _affinity = domain; }
+
 protected:
 
 	/**
@@ -164,6 +372,32 @@ protected:
 	 */
 	void registerOutput(OutputBase& output, std::string name);
 
+	/**
+	 * Register a statically typed input, multi-input, or output. The number 
+	 * of the port has to match the number of ports of the same kind that 
+	 * have been registered before.
+	 */
+	template <typename Port>
+	void registerInput(typename Port::port_type& input, std::string name, InputType inputType = Required) {
+
+		checkPortNumber(Port::number, _numInputs, name);
+		registerInput(input, name, inputType);
+	}
+
+	template <typename Port>
+	void registerInputs(typename Port::port_type& input, std::string name) {
+
+		checkPortNumber(Port::number, _numMultiInputs, name);
+		registerInputs(input, name);
+	}
+
+	template <typename Port>
+	void registerOutput(typename Port::port_type& output, std::string name) {
+
+		checkPortNumber(Port::number, _numOutputs, name);
+		registerOutput(output, name);
+	}
+
 	/**
 	 * Register an input-output dependency. Modified signals will only be sent 
 	 * to the registered outputs if the respective input is changing. If there 
@@ -173,6 +407,16 @@ protected:
 	void setDependency(InputBase&  input, OutputBase& output);
 	void setDependency(MultiInput& input, OutputBase& output);
 
+	/**
+	 * Register an input-output dependency between two port declarations, 
+	 * without look-ups of the port numbers.
+	 */
+	template <typename InPort, typename OutPort>
+	void setDependency() {
+
+		addPortDependency(static_cast<typename InPort::port_type*>(0), InPort::number, OutPort::number);
+	}
+
 	/**
 	 * Overwrite this method in derived classes to (re)compute the output.
 	 * Within this method you can assume that all inputs are up-to-date.
@@ -181,6 +425,18 @@ protected:
 	 */
 	virtual void updateOutputs() = 0;
 
+	/**
+	 * Overwrite this method in derived classes to recompute the outputs of 
+	 * several instances of the same type at once, e.g., to process the inputs 
+	 * of all instances with vector instructions. Called on one of the 
+	 * instances by the UpdateScheduler for batchable process nodes, see 
+	 * setBatchable(). The given instances are of the dynamic type of this 
+	 * process node and include it. As in updateOutputs(), all inputs are 
+	 * up-to-date and locked. The default implementation calls updateOutputs() 
+	 * on each instance.
+	 */
+	virtual void updateOutputsBatch(const std::vector<SimpleProcessNode*>& instances);
+
 	/**
 	 * Explicitly update the inputs of this process node. Usually, you don't
 	 * need to call this function yourself. It will be called automatically
@@ -193,6 +449,40 @@ protected:
 	 */
 	void updateInputs();
 
+	/**
+	 * Explicitly update a region of the inputs of this process node. The 
+	 * region is sent upstream with a RegionUpdate signal, process nodes that 
+	 * support regions will update only the requested part of their outputs. 
+	 * Inputs that were dirty stay dirty afterwards, since only the region is 
+	 * up-to-date. A later request for another region is sent upstream again.
+	 *
+	 * Thread save.
+	 */
+	void updateInputs(const Region& region);
+
+	/**
+	 * Non-blocking variant of updateInputs(). The update is executed on the 
+	 * thread pool, the returned future becomes ready when it finished. 
+	 * Requests that arrive while an earlier asynchronous update has not been 
+	 * started yet are merged into this update, therefore concurrent requests 
+	 * cause only one computation.
+	 *
+	 * Don't wait for the returned future within a task of the thread pool, 
+	 * this might deadlock if all workers are waiting. Use a continuation 
+	 * instead. Without workers in the thread pool, the update is performed 
+	 * before this method returns.
+	 *
+	 * The process node has to be owned by a shared pointer, which is held 
+	 * until the update finished.
+	 *
+	 * @param continuation Optional callback, executed after the update on the 
+	 *                     thread that performed the update.
+	 *
+	 * @throws boost::bad_weak_ptr If the process node is not owned by a 
+	 *         shared pointer. No update is requested in this case.
+	 */
+	boost::shared_future<void> updateInputsAsync(continuation_type continuation = continuation_type());
+
 	/**
 	 * Explicitly set one of the outputs dirty. This will cause other process
 	 * nodes to be informed accordingly. Use this method whenever you change the
@@ -205,8 +495,340 @@ protected:
 	 */
 	void setDirty(OutputBase& output);
 
+	/**
+	 * Explicitly set a region of one of the outputs dirty. See 
+	 * setDirty(OutputBase&).
+	 *
+	 * @param output The output to set dirty.
+	 * @param region The modified region of the output.
+	 */
+	void setDirty(OutputBase& output, const Region& region);
+
+	/**
+	 * Set an output dirty by its port declaration, without a look-up of the 
+	 * output number.
+	 */
+	template <typename Port>
+	void setDirty(const Region& region = Region::everything()) {
+
+		setDirtyOutput(Port::number, region);
+	}
+
+	/**
+	 * Get the union of the regions of the outputs that have been requested by 
+	 * the downstream process nodes for the current update. Within 
+	 * updateOutputs(), it is sufficient to compute this region. This is the 
+	 * whole region, if any of the requests did not specify a region.
+	 */
+	const Region& getRequestedRegion() const { return _requestedRegion; }
+
+	/**
+	 * Get the region of an output that was modified since the output was 
+	 * updated the last time.
+	 */
+	Region getModifiedRegion(OutputBase& output);
+
+	/**
+	 * Get the changes of a multi-input since the last call to updateOutputs():
+	 * the inputs that were modified, added, or removed. Use this within
+	 * updateOutputs() to aggregate only the changed inputs, see
+	 * IncrementalReducer. The changes are consumed when updateOutputs()
+	 * returns. If it throws, they are reported again on the next update.
+	 */
+	const MultiInputChanges& getChanges(MultiInput& input) {
+
+		std::map<InputBase*, unsigned int>::const_iterator i = _multiInputNums.find(&input);
+
+		if (i == _multiInputNums.end())
+			UTIL_THROW_EXCEPTION(
+					NoSuchInput,
+					"the multi-input is not registered with this process node");
+
+		return _multiInputChanges[i->second];
+	}
+
+	/**
+	 * Map a modified region of an input to the affected region of the 
+	 * outputs. Overwrite this method, if your outputs are not in the same 
+	 * coordinate frame as your inputs, or if you need a neighborhood around 
+	 * each input element. The default implementation returns the given 
+	 * region.
+	 */
+	virtual Region getAffectedRegion(const Region& inputRegion) { return inputRegion; }
+
+	/**
+	 * Map a requested region of the outputs to the region of the inputs that 
+	 * is needed to compute it. The default implementation returns the given 
+	 * region.
+	 */
+	virtual Region getRequiredRegion(const Region& outputRegion) { return outputRegion; }
+
+	/**
+	 * Enable or disable coalescing of Modified signals for this process node.
+	 * If enabled, a Modified signal is forwarded to an output only if the 
+	 * downstream process nodes asked for an update of this output since the 
+	 * last Modified signal. Bursts of modifications will therefore cause only 
+	 * one Modified signal per output. The default is given by the program 
+	 * option 'coalesceModified'.
+	 *
+	 * Coalescing also keeps the construction of large graphs cheap: every 
+	 * new connection modifies the outputs downstream of it, but each output 
+	 * forwards only the first of these Modified signals until it is updated. 
+	 * Building a graph therefore sends at most one Modified signal per 
+	 * output, instead of one per connection and output.
+	 *
+	 * Disable coalescing if you registered callbacks on the outputs that have 
+	 * to see every single modification.
+	 */
+	void setCoalesceModified(bool coalesce) { _coalesceModified = coalesce; }
+
+	/**
+	 * Returns true, if the inputs or the internal state of this process node 
+	 * changed since the current update started. Long running implementations 
+	 * of updateOutputs() can poll this method and return early, since their 
+	 * result will be recomputed on the next update anyway. In this case, the 
+	 * outputs should be left in a consistent state.
+	 */
+	bool isCancelled() const { return _modificationGeneration != _updateGeneration; }
+
+	/**
+	 * Enable or disable the cancellation of superseded updates. If enabled, 
+	 * input updates that have not been started and the call to 
+	 * updateOutputs() are skipped as soon as isCancelled() returns true. The 
+	 * skipped work is left for the next update. The default is given by the 
+	 * program option 'cancelSupersededUpdates'.
+	 */
+	void setCancelSupersededUpdates(bool cancel) { _cancelSuperseded = cancel; }
+
+	/**
+	 * Enable or disable prefetching of the outputs. If enabled, a Modified 
+	 * signal for any of the outputs schedules a speculative update on the 
+	 * next idle worker of the thread pool, such that a later update request 
+	 * finds the outputs up-to-date. Speculative updates are abandoned as 
+	 * soon as the inputs change during the update, the next Modified signal 
+	 * schedules a new one. Without workers, prefetching has no effect. The 
+	 * default is given by the program option 'prefetchOutputs'.
+	 *
+	 * Process nodes with prefetching enabled have to be owned by a shared 
+	 * pointer.
+	 */
+	void setPrefetch(bool prefetch) { _prefetch = prefetch; }
+
+	/**
+	 * Enable or disable the compiled dispatch of Update signals. If enabled, 
+	 * the upstream process nodes of all inputs are resolved once per 
+	 * connection epoch (see OutputBase::getConnectionEpoch()), and Update 
+	 * signals to SimpleProcessNodes are replaced by direct calls. Outputs that 
+	 * have other callbacks than the one of their process node still receive 
+	 * signals. The default is given by the program option 'compiledDispatch'.
+	 *
+	 * Only Update signals are compiled. Modified signals are sent by an output 
+	 * to all its consumers, including inputs of other kinds of process nodes 
+	 * and the internal callbacks of inputs, and are therefore always sent via 
+	 * the signal library.
+	 *
+	 * The resolved upstream process nodes form an immutable snapshot of the 
+	 * topology, which is replaced as a whole when the connections change. The 
+	 * snapshot does not keep the upstream process nodes alive, a direct call 
+	 * locks its receiver only for the duration of the call. Updates, direct 
+	 * or via signals, run against the snapshot of the epoch they started in, 
+	 * without holding the input mutex. Inputs can therefore be rewired while 
+	 * updates through them are in flight, the next update follows the new 
+	 * connections.
+	 */
+	void setCompiledDispatch(bool compiled) { _compiledDispatch = compiled; }
+
+	/**
+	 * Enable or disable the fusion of linear chains. A chain consists of 
+	 * process nodes with a single input, that are connected via outputs 
+	 * without other consumers (see OutputBase::getNumConsumers()). If enabled 
+	 * for all of its members, the process node at the end of a chain updates 
+	 * the chain iteratively from its head, instead of each member sending 
+	 * Update signals to its predecessor. The members find their input 
+	 * up-to-date and skip the Update propagation. Each member still locks its 
+	 * own data and sends Modified signals as in separate updates. 
+	 * Chains are resolved once per connection epoch (see 
+	 * OutputBase::getConnectionEpoch()), and only updates of whole regions are 
+	 * fused. The default is given by the program option 'fuseChains'.
+	 */
+	void setFuseChains(bool fuse) { _fuseChains = fuse; }
+
+	/**
+	 * Allow the UpdateScheduler to update this process node together with 
+	 * other batchable instances of the same type, which are ready at the same 
+	 * time, by a single call to updateOutputsBatch(). Caches, statistics, and 
+	 * regions are handled for each instance as for separate updates. The 
+	 * default is false.
+	 */
+	void setBatchable(bool batchable = true) { _batchable = batchable; }
+
+	/**
+	 * Allow the MemoryManager to release the data of the outputs of this 
+	 * process node, if the memory budget is exceeded. Released outputs are 
+	 * recomputed by the next update, therefore updateOutputs() has to be able 
+	 * to recreate the output data. Only data that reports its size (see 
+	 * Data::getSize()) is taken into account. Requires that this process 
+	 * node is owned by a shared pointer.
+	 *
+	 * Downstream process nodes release their references to evicted data only 
+	 * while they are not updating, such that the data can not vanish while it 
+	 * is read. Until then, the memory stays in use.
+	 */
+	void setEvictable(bool evictable = true) { _evictable = evictable; }
+
+	/**
+	 * Enable caching of output sets. Before updateOutputs() is called, the 
+	 * versions of all input data objects are compared to the versions that 
+	 * were used to compute the current and the previously cached outputs. If 
+	 * a match is found, the cached outputs are restored and updateOutputs() 
+	 * is skipped. This avoids recomputation if inputs toggle between states 
+	 * (A→B→A) or are set to the same shared pointer again.
+	 *
+	 * The cache relies on Data::getVersion(). Outputs of SimpleProcessNodes 
+	 * get a new version after each update. If you modify input data in place 
+	 * by other means, you have to call Data::touch() yourself. Changes of the 
+	 * internal state of this process node have to be reported via setDirty(), 
+	 * which invalidates the cache.
+	 *
+	 * @param size The number of output sets to keep. 0 disables the cache 
+	 *             (default), 1 only skips updates if the inputs did not change 
+	 *             since the last update. Each further cached output set keeps 
+	 *             the output data of a previous update alive.
+	 */
+	void setOutputCacheSize(unsigned int size);
+
+	/**
+	 * Store an output in the PersistentCache, such that later program runs 
+	 * can skip the update. Requires a Persistence trait for T. Outputs are 
+	 * only restored from the cache if all outputs of this process node are 
+	 * persistent.
+	 *
+	 * The key of a cache entry is computed from the type of this process 
+	 * node, its parameters (see writeParameters()), and the content keys of 
+	 * its inputs. Inputs with unknown content keys disable the persistent 
+	 * cache for the current update.
+	 */
+	template <typename T>
+	void enablePersistentCache(Output<T>& output) {
+
+		BOOST_STATIC_ASSERT(Persistence<T>::enabled);
+
+		std::map<OutputBase*, unsigned int>::const_iterator i = _outputNums.find(&output);
+
+		if (i == _outputNums.end())
+			UTIL_THROW_EXCEPTION(
+					NoSuchOutput,
+					"the output has to be registered before enabling the persistent cache for it");
+
+		_persistentOutputs[i->second] = boost::make_shared<PersistentOutput<T> >(boost::ref(output));
+	}
+
+	/**
+	 * Add all parameters of this process node that influence the outputs to 
+	 * the key of the persistent cache. The default implementation adds 
+	 * nothing.
+	 */
+	virtual void writeParameters(ContentHash& /*hash*/) {}
+
+	/**
+	 * Overwritten from ProcessNode.
+	 */
+	bool needsUpdate();
+
+	/**
+	 * Overwritten from ProcessNode.
+	 */
+	void updateScheduled();
+
+	/**
+	 * Overwritten from ProcessNode.
+	 */
+	bool isBatchable() { return _batchable; }
+
+	/**
+	 * Overwritten from ProcessNode.
+	 */
+	void updateScheduledBatch(const std::vector<ProcessNode*>& processNodes);
+
+	/**
+	 * Overwritten from ProcessNode. The moving average of the time spent in 
+	 * updateOutputs(), which is only measured if profiling is enabled.
+	 */
+	boost::uint64_t getEstimatedCost() { return _estimatedCost; }
+
+	/**
+	 * Overwritten from ProcessNode.
+	 */
+	int getDirectUpdateOutput(OutputBase& output);
+
+	/**
+	 * Overwritten from ProcessNode.
+	 */
+	void updateDirectly(const Update& signal, int numOutput);
+
+	/**
+	 * Overwritten from ProcessNode.
+	 */
+	bool isFusible() { return _fuseChains && _numInputs == 1 && _numMultiInputs == 0 && _numOutputs == 1; }
+
+	/**
+	 * Overwritten from ProcessNode.
+	 */
+	boost::shared_ptr<ProcessNode> getFusedUpstream();
+
+	/**
+	 * Overwritten from ProcessNode.
+	 */
+	bool clearFusedInput();
+
+	/**
+	 * Overwritten from ProcessNode.
+	 */
+	void setFusedInputDirty() { _inputDirty.set(0); }
+
+	/**
+	 * Overwritten from ProcessNode.
+	 */
+	void updateFused(bool inputModified);
+
 private:
 
+	// casts a port to the type of its declaration, verified in debug builds
+	template <typename Port, typename PortBaseType>
+	static typename Port::port_type& getPort(PortBaseType& port) {
+
+#ifndef NDEBUG
+		if (!dynamic_cast<typename Port::port_type*>(&port))
+			UTIL_THROW_EXCEPTION(
+					PortMismatch,
+					"port number " << Port::number << " of type " << typeName(port) << " does not match its declaration");
+#endif
+
+		return static_cast<typename Port::port_type&>(port);
+	}
+
+	static void checkPortNumber(unsigned int declared, unsigned int registered, const std::string& name);
+
+	void addPortDependency(InputBase*,  unsigned int inputNum, unsigned int outputNum);
+	void addPortDependency(MultiInput*, unsigned int inputNum, unsigned int outputNum);
+
+	// set an output dirty by its number
+	void setDirtyOutput(unsigned int outputNum, const Region& region);
+
+	// implements EvictableOutputs
+	bool evictOutputs();
+
+	// report the size of the outputs to the MemoryManager
+	void reportMemory(Profiler::time_type cost);
+
+	// get the region of a Modified or Update signal
+	static Region getSignalRegion(const Modified& signal);
+	static Region getSignalRegion(const Update& signal);
+
+	// mark the requested region as updated, assumes that _updateMutex is 
+	// locked
+	void finishRegions(const Region& requested);
+
 	void onInputModified(const Modified& signal, int numInput);
 
 	void onInputSet(const InputSetBase& signal, int numInput);
@@ -219,8 +841,22 @@ private:
 
 	void onMultiInputModified(const Modified& signal, int numInput, int numMultiInput);
 
+	// move the multi-input changes received so far to the changes of the
+	// current update, assumes that _updateMutex is locked
+	void takeChanges();
+
+	// forget the changes of the current update, called after updateOutputs()
+	// returned
+	void commitChanges();
+
 	void lockInputs(int i) {
 
+		if (LockingStrategy::LocksAtOnce) {
+
+			lockAtOnce();
+			return;
+		}
+
 		if (i == _numInputs) {
 
 			lockOutputs(0);
@@ -234,19 +870,154 @@ private:
 
 		if (i == _numOutputs) {
 
-			updateOutputs();
+			callUpdateOutputs();
 			return;
 		}
 
 		LockingStrategy::lockOutput(getOutput(i), boost::bind(&SimpleProcessNode::lockOutputs, this, i + 1));
 	}
 
+	// lock the data of all inputs and outputs in one pass and call 
+	// updateOutputs()
+	void lockAtOnce();
+
+	// lock the inputs and outputs and call updateOutputs() on the domain 
+	// given by the affinity of this process node
+	void lockInputsOnDomain();
+
+	// get the domain to update on, or -1 for the current thread
+	int getUpdateDomain(ThreadPool& pool);
+
+	// add the size of the data of an output to the vote for its domain
+	static void voteDomain(std::vector<double>& votes, OutputBase& output, boost::shared_ptr<Data> data);
+
+	// call updateOutputs() and record statistics, if profiling is enabled
+	void callUpdateOutputs();
+
+	// lock the data of all inputs and outputs of the instances in one pass 
+	// and call updateOutputsBatch(), for strategies that lock at once
+	void lockBatchAtOnce(const std::vector<SimpleProcessNode*>& instances);
+
+	// lock the inputs and outputs of the instances from k on, each input data 
+	// only once, and call updateOutputsBatch()
+	void lockBatchInputs(const std::vector<SimpleProcessNode*>& instances, unsigned int k, int i, std::set<Data*>& locked);
+	void lockBatchOutputs(const std::vector<SimpleProcessNode*>& instances, unsigned int k, int i, std::set<Data*>& locked);
+
+	// call updateOutputsBatch() and record statistics for each instance
+	void callUpdateOutputsBatch(const std::vector<SimpleProcessNode*>& instances);
+
+	// add the measured cost of an update to the estimated cost
+	void addMeasuredCost(Profiler::time_type cost);
+
+	// get the statistics of this process node, or 0 if profiling is 
+	// disabled, assumes that _updateMutex is locked
+	NodeStatistics* getStatistics();
+
 	void onUpdate(const Update& signal, int numOutput);
 
+	// performs the pending asynchronous update
+	void asyncUpdate(boost::shared_ptr<ProcessNode> self);
+
+	// update the given output (or all, if -1), assumes that _updateMutex is 
+	// locked
+	void update(int numOutput);
+
+	// the part of update() before the outputs are computed, returns true if 
+	// updateOutputs() has to be called
+	bool prepareUpdate(int numOutput, std::vector<boost::uint64_t>& key, boost::uint64_t& persistentKey);
+
+	// the first part of prepareUpdate(), brings the inputs up-to-date
+	void prepareInputs(int numOutput);
+
+	// the second part of prepareUpdate(), checks the caches and whether the 
+	// outputs have to be computed
+	bool prepareOutputs(std::vector<boost::uint64_t>& key, boost::uint64_t& persistentKey);
+
+	// the part of update() after the outputs have been computed
+	void finishUpdate(const std::vector<boost::uint64_t>& key, boost::uint64_t persistentKey, Profiler::time_type updateCost);
+
 	// thread save (by locking)
-	void sendUpdateSignals(int numOutput = -1);
+	void sendUpdateSignals(int numOutput = -1, const Region& region = Region::everything());
+
+	// an upstream process node that receives Update signals by direct calls
+	struct DirectUpdate {
+
+		DirectUpdate() :
+			output(0),
+			numOutput(-1) {}
+
+		// not owning, such that the snapshot does not keep removed upstream 
+		// process nodes alive
+		boost::weak_ptr<ProcessNode> processNode;
+
+		// the output the direct call replaces signals to
+		OutputBase* output;
+
+		// the number of the output in processNode
+		int numOutput;
+	};
+
+	// An immutable snapshot of the direct Update receivers of all inputs. A 
+	// new snapshot is published for each connection epoch, updates that are 
+	// in flight keep using the one they started with.
+	struct Topology {
+
+		unsigned int epoch;
+
+		std::vector<DirectUpdate>               inputs;
+		std::vector<std::vector<DirectUpdate> > multiInputs;
+	};
+
+	// resolve the direct Update receivers of all inputs and publish them as 
+	// a new topology, assumes that _inputMutex is locked
+	void compileDispatch();
+
+	// get the topology of the current connection epoch, assumes that 
+	// _inputMutex is locked
+	boost::shared_ptr<const Topology> getTopology();
+
+	static DirectUpdate resolveDirectUpdate(OutputBase* output);
+
+	// get the direct Update receiver of an input, or 0 if a signal has to be 
+	// sent, assumes that _inputMutex is locked
+	const DirectUpdate* getDirectUpdate(const Topology& topology, int numInput);
+	const DirectUpdate* getDirectUpdate(const Topology& topology, int numMultiInput, unsigned int i);
+
+	// update the fused chain upstream of the single input, if the input is 
+	// dirty, assumes that _updateMutex is locked
+	void updateFusedChain(int numOutput, const Region& region);
+
+	// get the fused chain upstream of this process node, from the direct 
+	// predecessor to the head, assumes that _updateMutex is locked
+	const std::vector<boost::shared_ptr<ProcessNode> >& getFusedChain();
+
+	// send an update signal through the given slot (or by a direct call to 
+	// the upstream process node), unless the current update was cancelled -- 
+	// in this case, the dirty flag of the input is restored; a null slot 
+	// stands for an input that is not connected to an output
+	void sendUpdateSignal(signals::Slot<Update>* slot, const DirectUpdate* direct, DirtyFlags& dirtyFlags, unsigned int i, const Region& region);
+
+	// same for the lazy slot of a multi-input, which is kept alive until the 
+	// signal was sent
+	void sendLazyUpdateSignal(boost::shared_ptr<signals::Slot<Update> > slot, const DirectUpdate* direct, DirtyFlags& dirtyFlags, unsigned int i, const Region& region);
+
+	// returns true, if the current update should be abandoned
+	bool abandonUpdate() const { return (_cancelSuperseded || _speculative) && isCancelled(); }
 
-	void sendModifiedSignals(int numIntput, int numMultiInput = -1);
+	// schedule a speculative update on an idle worker, unless one is pending 
+	// already
+	void schedulePrefetch();
+
+	// perform a speculative update, if the process node still exists and 
+	// needs it
+	static void prefetch(SimpleProcessNode* processNode, boost::weak_ptr<ProcessNode> self);
+
+	// remember the modification generation the current update is based on
+	void beginUpdate() { _updateGeneration = _modificationGeneration.load(); }
+
+	void sendModifiedSignals(int numIntput, int numMultiInput = -1, const Region& region = Region::everything());
+
+	void sendModifiedSignal(int numOutput, const Region& region = Region::everything());
 
 	bool haveDirtyInput();
 
@@ -261,13 +1032,46 @@ private:
 	bool inputOutputDepends(int numInput, int numOutput);
 	bool multiInputOutputDepends(int numInput, int numOutput);
 
+	// get the versions of the current inputs and internal state
+	void getCacheKey(std::vector<boost::uint64_t>& key);
+
+	// restore cached outputs with the given key, returns false if there are 
+	// none
+	bool restoreOutputs(const std::vector<boost::uint64_t>& key);
+
+	// add the current outputs to the cache
+	void cacheOutputs(const std::vector<boost::uint64_t>& key);
+
+	// get the persistent cache key of the current inputs, 0 if unknown
+	boost::uint64_t getPersistentKey();
+
+	// add the content key of an input, returns false if it is unknown
+	static bool addContentKey(ContentHash& hash, OutputBase* output, boost::shared_ptr<Data> data);
+
+	// restore all outputs from the persistent cache, returns false if not all 
+	// of them are stored
+	bool loadPersistentOutputs(boost::uint64_t key);
+
+	void storePersistentOutputs(boost::uint64_t key);
+
+	// the content key of an output computed from the given node key
+	static boost::uint64_t getOutputKey(boost::uint64_t key, unsigned int num);
+
+	// an output set computed from the input versions in key
+	struct CacheEntry {
+
+		std::vector<boost::uint64_t>          key;
+		std::vector<boost::shared_ptr<Data> > outputs;
+		std::vector<boost::uint64_t>          versions;
+	};
+
 	std::string getLogPrefix() { return std::string("[") + typeName(*this) + (_name.size() ? std::string("(") + _name + ")]" : "]"); }
 
-	// one boolean for each input
-	std::vector<bool> _inputDirty;
+	// one dirty flag for each input
+	DirtyFlags _inputDirty;
 
-	// a vector of booleans for each multi-input
-	std::vector<std::vector<bool> > _multiInputDirty;
+	// dirty flags for each multi-input
+	std::vector<DirtyFlags*> _multiInputDirty;
 
 	// a list of outputs that get dirty for each [mulit]input
 	std::vector<std::vector<int> > _inputDirtys;
@@ -280,8 +1084,15 @@ private:
 	// one update slot for each input
 	signals::Slots<Update>  _inputUpdate;
 
-	// a vector of slots for each multi-input
-	std::vector<signals::Slots<Update>*> _multiInputUpdates;
+	// lazily connected slots for each multi-input
+	std::vector<LazySlots<Update>*> _multiInputUpdates;
+
+	// for each multi-input, the changes received since the current update
+	// started (protected by _changesMutex) and the changes to be processed
+	// by the current update (protected by _updateMutex)
+	std::vector<MultiInputChanges> _pendingChanges;
+	std::vector<MultiInputChanges> _multiInputChanges;
+	boost::mutex                   _changesMutex;
 
 	// one modified slot for each output
 	signals::Slots<Modified> _modified;
@@ -296,27 +1107,119 @@ private:
 	int _numOutputs;
 
 	// indicates that an output has to be recomputed
-	std::vector<bool> _outputDirty;
+	DirtyFlags _outputDirty;
+
+	// indicates that a Modified signal was sent to an output since its last 
+	// update request
+	DirtyFlags _outputNotified;
+
+	// send Modified only on the first modification since the last update
+	bool _coalesceModified;
+
+	// replace Update signals by direct calls
+	bool _compiledDispatch;
+
+	// can be updated together with other instances
+	bool _batchable;
+
+	// the latest topology, replaced atomically (written under _inputMutex)
+	boost::shared_ptr<const Topology> _topology;
+
+	// update linear chains upstream by iteration
+	bool _fuseChains;
+
+	// the fused chain upstream of this process node, resolved in connection 
+	// epoch _fusedEpoch (protected by _updateMutex)
+	std::vector<boost::shared_ptr<ProcessNode> > _fusedChain;
+	unsigned int                                 _fusedEpoch;
+	bool                                         _fusedCompiled;
+
+	// incremented on every change of the inputs or the internal state
+	boost::atomic<unsigned int> _modificationGeneration;
+
+	// the modification generation at the start of the current update
+	boost::atomic<unsigned int> _updateGeneration;
+
+	// skip work of updates that have been superseded
+	bool _cancelSuperseded;
+
+	// update speculatively when an output gets modified
+	boost::atomic<bool> _prefetch;
+
+	// a prefetch was scheduled and did not start yet
+	boost::atomic<bool> _prefetchScheduled;
+
+	// the current update is a prefetch (protected by _updateMutex)
+	bool _speculative;
 
 	// a look-up table from outputs to their number
 	std::map<OutputBase*, unsigned int> _outputNums;
 
+	// for each output, the regions modified since its last update and 
+	// requested for the next update (protected by _regionMutex)
+	std::vector<Region> _outputModifiedRegion;
+	std::vector<Region> _outputRequestedRegion;
+
+	boost::mutex _regionMutex;
+
+	// the requested region of the current update
+	Region _requestedRegion;
+
 	// indicates that an input is required for the output update
 	std::vector<bool> _inputRequired;
 
 	// a mutex to protect concurrent updates
 	boost::mutex _updateMutex;
 
-	// a mutex to protect access to the _[multiI|i]nputDirty vectors
-	boost::mutex _inputDirtyMutex;
+	// a mutex to protect changes to the inputs, recursive since clearing a 
+	// multi-input via clearInputs() calls onInputsCleared() while locked
+	boost::recursive_mutex _inputMutex;
+
+	// cached output sets, most recently used first (protected by 
+	// _updateMutex)
+	std::list<CacheEntry> _outputCache;
+
+	// the maximal number of cached output sets
+	unsigned int _outputCacheSize;
+
+	// true, if the MemoryManager can release the outputs
+	bool _evictable;
+
+	// the domain to update on (or one of Affinity)
+	int _affinity;
+
+	// for each output, the handler for the persistent cache (or null)
+	std::vector<boost::shared_ptr<PersistentOutputBase> > _persistentOutputs;
+
+	// incremented by setDirty() to invalidate cached outputs
+	boost::atomic<boost::uint64_t> _stateVersion;
+
+	// a scheduled asynchronous update and the requests merged into it
+	struct AsyncUpdate {
+
+		boost::promise<void>           promise;
+		boost::shared_future<void>     future;
+		std::vector<continuation_type> continuations;
+	};
+
+	// the asynchronous update that has not been started yet (protected by 
+	// _asyncMutex)
+	boost::shared_ptr<AsyncUpdate> _pendingAsyncUpdate;
+
+	boost::mutex _asyncMutex;
+
+	// update statistics, created on first use if profiling is enabled
+	boost::shared_ptr<NodeStatistics> _statistics;
 
-	// a mutex to protect changes to the inputs
-	boost::mutex _inputMutex;
+	// started before the inputs and outputs get locked
+	ProfilingTimer _lockTimer;
 
-	// the maximal number of threads
-	static int _numThreads;
+	// the locks of the current update for strategies that lock at once, 
+	// reused between updates (protected by _updateMutex)
+	DataLocks _dataLocks;
 
-	static boost::mutex _threadCountMutex;
+	// the moving average of the measured update times
+	boost::atomic<boost::uint64_t> _estimatedCost;
 
 	// name to identify this process node in the logs
 	std::string _name;
@@ -0,0 +1,389 @@
+#ifndef PIPELINE_STREAM_H__
+#define PIPELINE_STREAM_H__
+
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <signals/Slot.h>
+#include "Data.h"
+#include "Input.h"
+#include "Logging.h"
+#include "Output.h"
+#include "signals/ChunkAvailable.h"
+
+namespace pipeline {
+
+/**
+ * A bounded stream of chunks of type T, passed from one producer to one 
+ * consumer through a lock-free ring buffer. The producer blocks while the 
+ * buffer is full, the consumer blocks while it is empty. Thus, the memory 
+ * used by a stream is bounded by its capacity, regardless of the total size 
+ * of the streamed data.
+ *
+ * Streams are usually not used directly, but through a StreamOutput and a 
+ * StreamInput.
+ */
+template <typename T>
+class Stream : public Data {
+
+public:
+
+	typedef boost::shared_ptr<T> chunk_type;
+
+	/**
+	 * Create a new stream.
+	 *
+	 * @param capacity The maximal number of chunks in the stream.
+	 */
+	Stream(unsigned int capacity) :
+		_chunks(capacity),
+		_closed(false),
+		_cancelled(false),
+		_producerWaiting(false),
+		_consumerWaiting(false) {}
+
+	/**
+	 * Add a chunk to the stream. Blocks while the stream is full.
+	 *
+	 * @return false, if the stream was cancelled.
+	 */
+	bool push(chunk_type chunk) {
+
+		if (!_chunks.push(chunk)) {
+
+			boost::mutex::scoped_lock lock(_mutex);
+
+			_producerWaiting = true;
+
+			// pairs with the fence in wakeup(): either the consumer sees our 
+			// flag, or we see its pop
+			boost::atomic_thread_fence(boost::memory_order_seq_cst);
+
+			while (!_cancelled && !_chunks.push(chunk))
+				_notFull.wait(lock);
+
+			_producerWaiting = false;
+		}
+
+		if (_cancelled)
+			return false;
+
+		wakeup(_consumerWaiting, _notEmpty);
+
+		return true;
+	}
+
+	/**
+	 * Get the next chunk of the stream. Blocks while the stream is empty.
+	 *
+	 * @return The next chunk, or an empty pointer at the end of the stream or 
+	 *         if the stream was cancelled.
+	 */
+	chunk_type pop() {
+
+		chunk_type chunk;
+
+		if (!_chunks.pop(chunk)) {
+
+			boost::mutex::scoped_lock lock(_mutex);
+
+			_consumerWaiting = true;
+
+			// pairs with the fence in wakeup(): either the producer sees our 
+			// flag, or we see its push
+			boost::atomic_thread_fence(boost::memory_order_seq_cst);
+
+			while (!_cancelled && !_chunks.pop(chunk)) {
+
+				// all chunks have been consumed
+				if (_closed && !_chunks.read_available())
+					break;
+
+				_notEmpty.wait(lock);
+			}
+
+			_consumerWaiting = false;
+		}
+
+		if (_cancelled)
+			return chunk_type();
+
+		wakeup(_producerWaiting, _notFull);
+
+		return chunk;
+	}
+
+	/**
+	 * Get the next chunk, if one is available.
+	 *
+	 * @return false, if the stream is empty.
+	 */
+	bool tryPop(chunk_type& chunk) {
+
+		if (_cancelled || !_chunks.pop(chunk))
+			return false;
+
+		wakeup(_producerWaiting, _notFull);
+
+		return true;
+	}
+
+	/**
+	 * Indicate the end of the stream. To be called by the producer after the 
+	 * last chunk was pushed.
+	 */
+	void close() {
+
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			_closed = true;
+		}
+
+		_notEmpty.notify_all();
+	}
+
+	/**
+	 * Abort the stream. Waiting producers and consumers return immediately, 
+	 * all further pushes fail and all further pops return empty pointers.
+	 */
+	void cancel() {
+
+		{
+			boost::mutex::scoped_lock lock(_mutex);
+			_cancelled = true;
+		}
+
+		_notEmpty.notify_all();
+		_notFull.notify_all();
+	}
+
+	/**
+	 * Returns true, if the stream was closed and all chunks have been 
+	 * consumed, or if it was cancelled.
+	 */
+	bool atEnd() const {
+
+		return _cancelled || (_closed && !_chunks.read_available());
+	}
+
+	bool isCancelled() const { return _cancelled; }
+
+private:
+
+	// non-copyable
+	Stream(const Stream&);
+	Stream& operator=(const Stream&);
+
+	// wake up the other side, if it is waiting
+	void wakeup(const boost::atomic<bool>& waiting, boost::condition_variable& condition) {
+
+		// the queue publishes with release/acquire only, which does not order 
+		// our push or pop before the load of the flag below
+		boost::atomic_thread_fence(boost::memory_order_seq_cst);
+
+		if (!waiting)
+			return;
+
+		// taking the lock ensures that the waiting thread is either in wait() 
+		// or will see the change before it waits
+		boost::mutex::scoped_lock lock(_mutex);
+		condition.notify_all();
+	}
+
+	boost::lockfree::spsc_queue<chunk_type> _chunks;
+
+	boost::atomic<bool> _closed;
+	boost::atomic<bool> _cancelled;
+
+	// the blocking paths only
+	boost::mutex              _mutex;
+	boost::condition_variable _notFull;
+	boost::condition_variable _notEmpty;
+
+	boost::atomic<bool> _producerWaiting;
+	boost::atomic<bool> _consumerWaiting;
+};
+
+/**
+ * An output that streams chunks of type T to a StreamInput. The chunks are 
+ * produced on a dedicated thread, such that consecutive streaming stages run 
+ * concurrently. A ChunkAvailable signal is sent forward for each chunk.
+ *
+ * Usage example:
+ *
+ *   class TileReader : public SimpleProcessNode<> {
+ *
+ *     StreamOutput<Tile> _tiles;
+ *
+ *     void updateOutputs() {
+ *
+ *       _tiles.produce(boost::bind(&TileReader::readTiles, this));
+ *     }
+ *
+ *     void readTiles() {
+ *
+ *       for (...)
+ *         if (!_tiles.push(readTile(...)))
+ *           return;
+ *     }
+ *   };
+ */
+template <typename T>
+class StreamOutput : public Output<Stream<T> > {
+
+	typedef Output<Stream<T> > parent_type;
+
+public:
+
+	typedef typename Stream<T>::chunk_type chunk_type;
+
+	/**
+	 * Create a new stream output.
+	 *
+	 * @param capacity The number of chunks that can be in flight between the 
+	 *                 producer and the consumer.
+	 */
+	StreamOutput(unsigned int capacity = 16) :
+		_capacity(capacity) {
+
+		this->registerSlot(_chunkAvailable);
+	}
+
+	~StreamOutput() {
+
+		stop();
+	}
+
+	/**
+	 * Start a new stream, which replaces the current stream of this output. 
+	 * The producer function is executed on a dedicated thread and should 
+	 * push() chunks until it is done or push() returns false. The stream will 
+	 * be closed after the producer returned. A stream that is still in 
+	 * progress will be cancelled.
+	 */
+	void produce(boost::function<void()> producer) {
+
+		stop();
+
+		_stream = boost::make_shared<Stream<T> >(_capacity);
+
+		parent_type::operator=(_stream);
+
+		_producer.reset(new boost::thread(boost::bind(&StreamOutput<T>::run, this, _stream, producer)));
+	}
+
+	/**
+	 * Push a chunk into the current stream. To be called by the producer 
+	 * function. Blocks while the stream is full.
+	 *
+	 * @return false, if the stream was cancelled.
+	 */
+	bool push(chunk_type chunk) {
+
+		if (!_stream || !_stream->push(chunk))
+			return false;
+
+		_chunkAvailable();
+
+		return true;
+	}
+
+	/**
+	 * Cancel the current stream and wait for the producer to finish.
+	 */
+	void stop() {
+
+		if (!_producer)
+			return;
+
+		_stream->cancel();
+		_producer->join();
+		_producer.reset();
+	}
+
+private:
+
+	void run(boost::shared_ptr<Stream<T> > stream, boost::function<void()> producer) {
+
+		try {
+
+			producer();
+
+		} catch (...) {
+
+			LOG_ERROR(pipelinelog)
+					<< "[StreamOutput] producer threw an exception: "
+					<< boost::current_exception_diagnostic_information() << std::endl;
+		}
+
+		stream->close();
+	}
+
+	unsigned int _capacity;
+
+	// the current stream
+	boost::shared_ptr<Stream<T> > _stream;
+
+	// the thread producing the current stream
+	boost::scoped_ptr<boost::thread> _producer;
+
+	signals::Slot<ChunkAvailable> _chunkAvailable;
+};
+
+/**
+ * An input that consumes the chunks of a StreamOutput.
+ */
+template <typename T>
+class StreamInput : public Input<Stream<T> > {
+
+public:
+
+	typedef typename Stream<T>::chunk_type chunk_type;
+
+	/**
+	 * Get the next chunk of the stream. Blocks until a chunk is available.
+	 *
+	 * @return The next chunk, or an empty pointer at the end of the stream.
+	 */
+	chunk_type pop() {
+
+		boost::shared_ptr<Stream<T> > stream = this->getSharedPointer();
+
+		if (!stream)
+			return chunk_type();
+
+		return stream->pop();
+	}
+
+	/**
+	 * Get the next chunk, if one is available.
+	 */
+	bool tryPop(chunk_type& chunk) {
+
+		boost::shared_ptr<Stream<T> > stream = this->getSharedPointer();
+
+		return stream && stream->tryPop(chunk);
+	}
+
+	/**
+	 * Returns true, if all chunks of the current stream have been consumed.
+	 */
+	bool atEnd() {
+
+		boost::shared_ptr<Stream<T> > stream = this->getSharedPointer();
+
+		return !stream || stream->atEnd();
+	}
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_STREAM_H__
+
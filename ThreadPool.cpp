@@ -0,0 +1,580 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/once.hpp>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include "ThreadPool.h"
+
+logger::LogChannel threadpoollog("threadpoollog", "[ThreadPool] ");
+
+namespace pipeline {
+
+util::ProgramOption optionNumThreads(
+		util::_module           = "pipeline",
+		util::_long_name        = "numThreads",
+		util::_description_text = "Set the number of additional threads to parallelize independent processes.",
+		util::_default_value    = 0);
+
+util::ProgramOption optionNumaDomains(
+		util::_module           = "pipeline",
+		util::_long_name        = "numaDomains",
+		util::_description_text = "Distribute the threads on this many NUMA domains and pin each thread to the CPUs of its "
+		                          "domain. Process nodes can be bound to a domain, see SimpleProcessNode::setAffinity().",
+		util::_default_value    = 0);
+
+boost::thread_specific_ptr<ThreadPool::WorkerInfo> ThreadPool::_workerInfo;
+
+namespace {
+
+ThreadPool*     globalPool = 0;
+boost::once_flag globalPoolFlag = BOOST_ONCE_INIT;
+
+// how long a thread waiting for a task group lets the workers of another
+// domain pick up a task, before it executes the task itself
+const boost::posix_time::milliseconds DomainTaskTimeout(1);
+
+void createGlobalPool() {
+
+	int numThreads = optionNumThreads;
+	int numDomains = optionNumaDomains;
+
+	// The global pool is never destructed: Its workers might still be
+	// referenced by static objects that get destructed at program exit.
+	globalPool = new ThreadPool(numThreads > 0 ? numThreads : 0, numDomains > 0 ? numDomains : 0);
+}
+
+/**
+ * Get the CPUs of a NUMA domain. If the operating system reports the CPUs of
+ * the domain, they are used. Otherwise, the CPUs are split into equally sized
+ * blocks of consecutive CPUs.
+ */
+std::vector<unsigned int> getDomainCpus(unsigned int domain, unsigned int numDomains) {
+
+	std::vector<unsigned int> cpus;
+
+	// a list of CPU ranges, like "0-7,16-23"
+	std::ifstream cpulist(("/sys/devices/system/node/node" + boost::lexical_cast<std::string>(domain) + "/cpulist").c_str());
+
+	std::string range;
+	while (std::getline(cpulist, range, ',')) {
+
+		unsigned int first = 0;
+		unsigned int last  = 0;
+		char         dash  = 0;
+
+		std::istringstream rangeStream(range);
+		rangeStream >> first;
+
+		if (!rangeStream)
+			continue;
+
+		if (rangeStream >> dash >> last)
+			for (unsigned int cpu = first; cpu <= last; cpu++)
+				cpus.push_back(cpu);
+		else
+			cpus.push_back(first);
+	}
+
+	if (!cpus.empty())
+		return cpus;
+
+	unsigned int numCpus = boost::thread::hardware_concurrency();
+
+	for (unsigned int cpu = domain*numCpus/numDomains; cpu < (domain + 1)*numCpus/numDomains; cpu++)
+		cpus.push_back(cpu);
+
+	return cpus;
+}
+
+} // anonymous namespace
+
+ThreadPool&
+ThreadPool::getInstance() {
+
+	boost::call_once(globalPoolFlag, &createGlobalPool);
+
+	return *globalPool;
+}
+
+ThreadPool::ThreadPool(unsigned int numWorkers, unsigned int numDomains) :
+	_numQueued(0),
+	_nextQueue(0),
+	_numActive(numWorkers),
+	_shutdown(false) {
+
+	for (unsigned int i = 0; i < numWorkers; i++)
+		_queues.push_back(new WorkerQueue());
+
+	// consecutive workers share a domain, such that they steal from each 
+	// other first
+	_domainWorkers.resize(numDomains);
+	_numQueuedInDomain.reset(new boost::atomic<unsigned int>[numDomains]);
+
+	for (unsigned int i = 0; i < numWorkers; i++) {
+
+		int domain = (numDomains > 0 ? i*numDomains/numWorkers : -1);
+
+		_workerDomains.push_back(domain);
+
+		if (domain >= 0)
+			_domainWorkers[domain].push_back(i);
+	}
+
+	for (unsigned int d = 0; d < numDomains; d++)
+		_numQueuedInDomain[d] = 0;
+
+	for (unsigned int i = 0; i < numWorkers; i++)
+		_workers.create_thread(boost::bind(&ThreadPool::workerLoop, this, i));
+
+	LOG_DEBUG(threadpoollog) << "started " << numWorkers << " workers in " << numDomains << " domains" << std::endl;
+}
+
+ThreadPool::~ThreadPool() {
+
+	{
+		boost::mutex::scoped_lock lock(_sleepMutex);
+		_shutdown = true;
+	}
+
+	_parked.notify_all();
+	_wakeup.notify_all();
+	_workers.join_all();
+
+	for (unsigned int i = 0; i < _queues.size(); i++)
+		delete _queues[i];
+}
+
+int
+ThreadPool::getCurrentDomain() const {
+
+	WorkerInfo* info = _workerInfo.get();
+
+	if (info && info->pool == this)
+		return info->domain;
+
+	return -1;
+}
+
+void
+ThreadPool::schedule(task_type task) {
+
+	task_pointer t(new Task(task, 0));
+
+	if (getNumWorkers() == 0) {
+
+		t->claimed = true;
+		execute(t);
+		return;
+	}
+
+	enqueue(t);
+}
+
+bool
+ThreadPool::scheduleIdle(task_type task) {
+
+	if (getNumWorkers() == 0)
+		return false;
+
+	{
+		boost::mutex::scoped_lock lock(_sleepMutex);
+		_idleTasks.push_back(task_pointer(new Task(task, 0)));
+	}
+
+	// any active worker can execute idle tasks
+	_wakeup.notify_one();
+
+	return true;
+}
+
+int
+ThreadPool::checkDomain(int domain) const {
+
+	if (domain < 0 || domain >= static_cast<int>(getNumDomains()) || _domainWorkers[domain].empty())
+		return -1;
+
+	return domain;
+}
+
+void
+ThreadPool::enqueue(task_pointer task) {
+
+	unsigned int queue;
+
+	// tasks submitted by our own workers stay with the submitting worker, 
+	// unless they have to be executed on another domain
+	WorkerInfo* info = _workerInfo.get();
+	if (info && info->pool == this && (task->domain < 0 || task->domain == info->domain))
+		queue = info->id;
+	else if (task->domain >= 0)
+		queue = _domainWorkers[task->domain][_nextQueue++ % _domainWorkers[task->domain].size()];
+	else
+		queue = _nextQueue++ % std::max(static_cast<unsigned int>(_numActive), 1u);
+
+	{
+		boost::mutex::scoped_lock lock(_queues[queue]->mutex);
+		_queues[queue]->tasks.push_back(task);
+	}
+
+	{
+		boost::mutex::scoped_lock lock(_sleepMutex);
+
+		if (task->domain >= 0)
+			_numQueuedInDomain[task->domain]++;
+		else
+			_numQueued++;
+	}
+
+	// only the workers of the domain can execute the task, but we can not 
+	// choose which worker to wake up
+	if (task->domain >= 0)
+		_wakeup.notify_all();
+	else
+		_wakeup.notify_one();
+}
+
+void
+ThreadPool::workerLoop(unsigned int id) {
+
+	_workerInfo.reset(new WorkerInfo(this, id, _workerDomains[id]));
+
+	if (_workerDomains[id] >= 0)
+		pinWorker(id);
+
+	while (true) {
+
+		task_pointer task;
+
+		// inactive workers leave their queue to the others, idle tasks are 
+		// only considered if there is nothing else to do
+		if (id < _numActive && (popTask(id, task) || popIdleTask(task))) {
+
+			// the task might have been executed already by the thread waiting
+			// for its group
+			if (!task->claimed.exchange(true))
+				execute(task);
+
+			continue;
+		}
+
+		boost::mutex::scoped_lock lock(_sleepMutex);
+
+		while (!_shutdown) {
+
+			// inactive workers wait separately, such that a notification of 
+			// one worker always reaches an active one
+			if (id >= _numActive)
+				_parked.wait(lock);
+			else if (_numQueued == 0 && _idleTasks.empty() && (_workerDomains[id] < 0 || _numQueuedInDomain[_workerDomains[id]] == 0))
+				_wakeup.wait(lock);
+			else
+				break;
+		}
+
+		if (_shutdown)
+			return;
+	}
+}
+
+unsigned int
+ThreadPool::setNumActiveWorkers(unsigned int numActive) {
+
+	unsigned int previous = _numActive;
+
+	if (getNumWorkers() == 0)
+		return previous;
+
+	numActive = std::min(std::max(numActive, 1u), getNumWorkers());
+
+	if (numActive == previous)
+		return previous;
+
+	LOG_DEBUG(threadpoollog) << "using " << numActive << " of " << getNumWorkers() << " workers" << std::endl;
+
+	{
+		boost::mutex::scoped_lock lock(_sleepMutex);
+		_numActive = numActive;
+	}
+
+	_parked.notify_all();
+	_wakeup.notify_all();
+
+	return previous;
+}
+
+void
+ThreadPool::pinWorker(unsigned int id) {
+
+	std::vector<unsigned int> cpus = getDomainCpus(_workerDomains[id], getNumDomains());
+
+#ifdef __linux__
+
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+
+	for (unsigned int i = 0; i < cpus.size(); i++)
+		CPU_SET(cpus[i], &cpuSet);
+
+	if (cpus.empty() || pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet) != 0) {
+
+		LOG_ERROR(threadpoollog) << "could not pin worker " << id << " to domain " << _workerDomains[id] << std::endl;
+		return;
+	}
+
+	LOG_DEBUG(threadpoollog)
+			<< "pinned worker " << id << " to " << cpus.size()
+			<< " CPUs of domain " << _workerDomains[id] << std::endl;
+
+#else
+
+	LOG_DEBUG(threadpoollog) << "pinning of workers is not supported on this platform" << std::endl;
+
+#endif
+}
+
+bool
+ThreadPool::isExecutable(const Task& task, unsigned int id) const {
+
+	return task.domain < 0 || task.domain == _workerDomains[id];
+}
+
+bool
+ThreadPool::popTask(unsigned int id, task_pointer& task) {
+
+	// oldest task of our own queue first (which are all executable by us), 
+	// such that earlier tasks are not starved by the ones submitted after 
+	// them
+	{
+		boost::mutex::scoped_lock lock(_queues[id]->mutex);
+
+		if (!_queues[id]->tasks.empty()) {
+
+			task = _queues[id]->tasks.front();
+			_queues[id]->tasks.pop_front();
+
+			if (task->domain >= 0)
+				_numQueuedInDomain[task->domain]--;
+			else
+				_numQueued--;
+
+			return true;
+		}
+	}
+
+	// steal the oldest executable task of another worker, workers of the same 
+	// domain are next to each other
+	for (unsigned int i = 1; i < _queues.size(); i++) {
+
+		WorkerQueue& victim = *_queues[(id + i) % _queues.size()];
+
+		boost::mutex::scoped_lock lock(victim.mutex);
+
+		for (std::deque<task_pointer>::iterator t = victim.tasks.begin(); t != victim.tasks.end(); t++) {
+
+			if (!isExecutable(**t, id))
+				continue;
+
+			task = *t;
+			victim.tasks.erase(t);
+
+			if (task->domain >= 0)
+				_numQueuedInDomain[task->domain]--;
+			else
+				_numQueued--;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool
+ThreadPool::popIdleTask(task_pointer& task) {
+
+	boost::mutex::scoped_lock lock(_sleepMutex);
+
+	if (_idleTasks.empty())
+		return false;
+
+	task = _idleTasks.front();
+	_idleTasks.pop_front();
+
+	return true;
+}
+
+void
+ThreadPool::execute(task_pointer task) {
+
+	boost::exception_ptr exception;
+
+	try {
+
+		task->function();
+
+	} catch (...) {
+
+		exception = boost::current_exception();
+	}
+
+	// release resources bound to the function as early as possible
+	task->function.clear();
+
+	if (task->group) {
+
+		task->group->finished(exception);
+
+	} else if (exception) {
+
+		LOG_ERROR(threadpoollog)
+				<< "scheduled task threw an exception: "
+				<< boost::diagnostic_information(exception) << std::endl;
+	}
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool) :
+	_pool(pool),
+	_firstUnclaimed(0),
+	_pending(0) {}
+
+TaskGroup::~TaskGroup() {
+
+	waitAll();
+}
+
+void
+TaskGroup::run(ThreadPool::task_type task, int domain) {
+
+	ThreadPool::task_pointer t(new ThreadPool::Task(task, this, _pool.checkDomain(domain)));
+
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+
+		_tasks.push_back(t);
+		_pending++;
+	}
+
+	_changed.notify_all();
+
+	// without workers, the tasks will be executed in wait()
+	if (_pool.getNumWorkers() > 0)
+		_pool.enqueue(t);
+}
+
+void
+TaskGroup::wait() {
+
+	waitAll();
+
+	boost::exception_ptr exception;
+
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+		std::swap(exception, _exception);
+	}
+
+	if (exception)
+		boost::rethrow_exception(exception);
+}
+
+void
+TaskGroup::waitAll() {
+
+	boost::mutex::scoped_lock lock(_mutex);
+
+	int domain = _pool.getCurrentDomain();
+
+	// leave the tasks of other domains to their workers for a while
+	bool patient = true;
+
+	while (_pending > 0) {
+
+		// find a task that was not started, yet
+		while (_firstUnclaimed < _tasks.size() && _tasks[_firstUnclaimed]->claimed)
+			_firstUnclaimed++;
+
+		ThreadPool::task_pointer task;
+		bool                     otherDomain = false;
+
+		for (unsigned int i = _firstUnclaimed; i < _tasks.size(); i++) {
+
+			if (_tasks[i]->claimed)
+				continue;
+
+			if (patient && _tasks[i]->domain >= 0 && _tasks[i]->domain != domain) {
+
+				otherDomain = true;
+				continue;
+			}
+
+			task = _tasks[i];
+			break;
+		}
+
+		if (task) {
+
+			lock.unlock();
+
+			// help with the work
+			if (!task->claimed.exchange(true))
+				ThreadPool::execute(task);
+
+			lock.lock();
+
+			continue;
+		}
+
+		// all remaining tasks are in progress or wait for another domain
+		if (otherDomain) {
+
+			if (!_changed.timed_wait(lock, DomainTaskTimeout))
+				patient = false;
+
+			continue;
+		}
+
+		_changed.wait(lock);
+	}
+
+	_tasks.clear();
+	_firstUnclaimed = 0;
+}
+
+void
+TaskGroup::finished(boost::exception_ptr exception) {
+
+	{
+		boost::mutex::scoped_lock lock(_mutex);
+
+		if (exception && !_exception)
+			_exception = exception;
+
+		_pending--;
+
+		// notify while holding the lock, the waiting thread might destruct
+		// this group as soon as it sees _pending reach zero
+		_changed.notify_all();
+	}
+}
+
+ScopedActiveWorkers::ScopedActiveWorkers(unsigned int numActive, ThreadPool& pool) :
+	_pool(pool),
+	_previous(pool.setNumActiveWorkers(numActive)) {}
+
+ScopedActiveWorkers::~ScopedActiveWorkers() {
+
+	_pool.setNumActiveWorkers(_previous);
+}
+
+} // namespace pipeline
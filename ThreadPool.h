@@ -0,0 +1,334 @@
+#ifndef PIPELINE_THREAD_POOL_H__
+#define PIPELINE_THREAD_POOL_H__
+
+#include <deque>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+namespace pipeline {
+
+// forward declaration
+class TaskGroup;
+
+/**
+ * A process-wide pool of persistent worker threads. Each worker owns a task
+ * queue. Tasks submitted from within a worker are pushed to the worker's own
+ * queue and processed in FIFO order, idle workers steal the oldest tasks from
+ * the queues of other workers.
+ *
+ * Tasks are usually submitted through a TaskGroup, which allows the submitting
+ * thread to wait for their completion while executing not-yet-started tasks of
+ * the group itself.
+ *
+ * The workers can be partitioned into NUMA domains. Each worker is pinned to
+ * the CPUs of its domain, and tasks can be submitted to a domain, such that
+ * the task runs close to the memory it accesses. Memory allocated by such a
+ * task is placed on the domain as well (given the first-touch policy of the
+ * operating system).
+ */
+class ThreadPool {
+
+public:
+
+	typedef boost::function<void()> task_type;
+
+	/**
+	 * Get the process-wide thread pool. The pool is created on first use with
+	 * as many workers as given by the program option 'numThreads', partitioned
+	 * into as many domains as given by the program option 'numaDomains'.
+	 */
+	static ThreadPool& getInstance();
+
+	/**
+	 * Create a new thread pool.
+	 *
+	 * @param numWorkers The number of worker threads to start.
+	 * @param numDomains The number of NUMA domains to distribute the workers
+	 *                   on. For 0 (the default), the workers are not pinned
+	 *                   and tasks can not be submitted to domains.
+	 */
+	ThreadPool(unsigned int numWorkers, unsigned int numDomains = 0);
+
+	/**
+	 * Stops all workers. Tasks that have not been started yet are discarded.
+	 */
+	~ThreadPool();
+
+	/**
+	 * Get the number of worker threads of this pool.
+	 */
+	unsigned int getNumWorkers() const { return _queues.size(); }
+
+	/**
+	 * Limit the number of workers that execute tasks. The other workers sleep 
+	 * until they are activated again. Tasks for a domain without active 
+	 * workers are executed by the thread waiting for them.
+	 *
+	 * The limit applies to all users of this pool until it is changed again. 
+	 * Use a ScopedActiveWorkers to limit the workers temporarily.
+	 *
+	 * @param numActive The number of workers to keep busy, between 1 and the 
+	 *                  number of workers.
+	 * @return The previous number of active workers.
+	 */
+	unsigned int setNumActiveWorkers(unsigned int numActive);
+
+	/**
+	 * Get the number of workers that execute tasks.
+	 */
+	unsigned int getNumActiveWorkers() const { return _numActive; }
+
+	/**
+	 * Get the number of NUMA domains of this pool.
+	 */
+	unsigned int getNumDomains() const { return _domainWorkers.size(); }
+
+	/**
+	 * Get the NUMA domain of the calling thread.
+	 *
+	 * @return The domain, or -1 if the calling thread is not a worker of this
+	 *         pool or the pool does not have domains.
+	 */
+	int getCurrentDomain() const;
+
+	/**
+	 * Check whether a NUMA domain exists and has workers.
+	 *
+	 * @return The given domain, or -1 if tasks for this domain would be 
+	 *         executed anywhere.
+	 */
+	int checkDomain(int domain) const;
+
+	/**
+	 * Schedule a task for asynchronous execution, without waiting for it.
+	 * Exceptions thrown by the task will be logged and dropped. If this pool
+	 * does not have any workers, the task is executed immediately.
+	 */
+	void schedule(task_type task);
+
+	/**
+	 * Schedule a task to be executed by a worker that has nothing else to 
+	 * do. Idle tasks are started in the order they were scheduled, only if 
+	 * no other task is queued. They are dropped if this pool does not have 
+	 * any workers, or if the pool is destructed before they were started.
+	 * Exceptions thrown by the task will be logged and dropped.
+	 *
+	 * @return False, if the task was dropped.
+	 */
+	bool scheduleIdle(task_type task);
+
+private:
+
+	// TaskGroup submits tasks directly
+	friend class TaskGroup;
+
+	struct Task {
+
+		Task(task_type function_, TaskGroup* group_, int domain_ = -1) :
+			function(function_),
+			group(group_),
+			domain(domain_),
+			claimed(false) {}
+
+		task_type function;
+
+		// the group this task belongs to (can be 0)
+		TaskGroup* group;
+
+		// the domain this task has to be executed on (-1 for any)
+		int domain;
+
+		// set by whoever is going to execute this task
+		boost::atomic<bool> claimed;
+	};
+
+	typedef boost::shared_ptr<Task> task_pointer;
+
+	struct WorkerQueue {
+
+		boost::mutex             mutex;
+		std::deque<task_pointer> tasks;
+	};
+
+	struct WorkerInfo {
+
+		WorkerInfo(ThreadPool* pool_, unsigned int id_, int domain_) :
+			pool(pool_),
+			id(id_),
+			domain(domain_) {}
+
+		ThreadPool*  pool;
+		unsigned int id;
+		int          domain;
+	};
+
+	void enqueue(task_pointer task);
+
+	void pinWorker(unsigned int id);
+
+	bool isExecutable(const Task& task, unsigned int id) const;
+
+	void workerLoop(unsigned int id);
+
+	bool popTask(unsigned int id, task_pointer& task);
+
+	bool popIdleTask(task_pointer& task);
+
+	static void execute(task_pointer task);
+
+	// one task queue for each worker
+	std::vector<WorkerQueue*> _queues;
+
+	boost::thread_group _workers;
+
+	// the number of tasks of any domain currently stored in all queues
+	boost::atomic<unsigned int> _numQueued;
+
+	// the domain of each worker (-1 if there are no domains)
+	std::vector<int> _workerDomains;
+
+	// the workers of each domain
+	std::vector<std::vector<unsigned int> > _domainWorkers;
+
+	// the number of tasks for each domain currently stored in all queues
+	boost::scoped_array<boost::atomic<unsigned int> > _numQueuedInDomain;
+
+	// used to distribute tasks submitted from non-worker threads
+	boost::atomic<unsigned int> _nextQueue;
+
+	// workers with an id from this number on sleep
+	boost::atomic<unsigned int> _numActive;
+
+	// idle workers wait for this condition
+	boost::mutex              _sleepMutex;
+	boost::condition_variable _wakeup;
+
+	// inactive workers wait for this condition (with _sleepMutex)
+	boost::condition_variable _parked;
+
+	// tasks for otherwise idle workers (protected by _sleepMutex)
+	std::deque<task_pointer> _idleTasks;
+
+	bool _shutdown;
+
+	// identifies the pool and worker of the current thread
+	static boost::thread_specific_ptr<WorkerInfo> _workerInfo;
+};
+
+/**
+ * A group of tasks that are executed by a thread pool. The thread that waits
+ * for the group helps executing the tasks of this group that have not been
+ * started by a worker yet. Therefore, waiting on a group never deadlocks due
+ * to a lack of free workers, and nested groups can be used safely from within
+ * tasks.
+ */
+class TaskGroup {
+
+public:
+
+	/**
+	 * Create a new task group for the given thread pool.
+	 */
+	TaskGroup(ThreadPool& pool = ThreadPool::getInstance());
+
+	/**
+	 * Waits for all tasks of this group to finish.
+	 */
+	~TaskGroup();
+
+	/**
+	 * Submit a task to this group.
+	 *
+	 * @param task   The task to execute.
+	 * @param domain The NUMA domain to execute the task on, or -1 for any. 
+	 *               Tasks for a domain are only executed by the workers of 
+	 *               this domain. If none of them picks up the task in time, 
+	 *               the thread waiting for the group executes it nevertheless.
+	 *               If the domain does not exist, the task can be executed 
+	 *               anywhere.
+	 */
+	void run(ThreadPool::task_type task, int domain = -1);
+
+	/**
+	 * Returns true, if tasks submitted to this group can be executed in
+	 * parallel, i.e., if the thread pool has workers.
+	 */
+	bool isParallel() const { return _pool.getNumWorkers() > 0; }
+
+	/**
+	 * Wait for all tasks of this group to finish. While waiting, the calling
+	 * thread executes tasks of this group that have not been started yet. If
+	 * one of the tasks threw an exception, the first one will be rethrown
+	 * here.
+	 */
+	void wait();
+
+private:
+
+	// the thread pool reports finished tasks
+	friend class ThreadPool;
+
+	void finished(boost::exception_ptr exception);
+
+	void waitAll();
+
+	ThreadPool& _pool;
+
+	boost::mutex              _mutex;
+	boost::condition_variable _changed;
+
+	// all tasks submitted since the last wait
+	std::vector<ThreadPool::task_pointer> _tasks;
+
+	// all tasks before this one have been claimed already
+	unsigned int _firstUnclaimed;
+
+	// the number of tasks that did not finish yet
+	unsigned int _pending;
+
+	// the first exception thrown by one of the tasks
+	boost::exception_ptr _exception;
+};
+
+/**
+ * Limits the number of active workers of a thread pool for the lifetime of 
+ * this object, and restores the previous number on destruction.
+ */
+class ScopedActiveWorkers {
+
+public:
+
+	/**
+	 * Set the number of active workers of the given thread pool.
+	 */
+	ScopedActiveWorkers(unsigned int numActive, ThreadPool& pool = ThreadPool::getInstance());
+
+	/**
+	 * Restore the number of active workers before the construction.
+	 */
+	~ScopedActiveWorkers();
+
+private:
+
+	// non-copyable
+	ScopedActiveWorkers(const ScopedActiveWorkers&);
+	ScopedActiveWorkers& operator=(const ScopedActiveWorkers&);
+
+	ThreadPool& _pool;
+
+	unsigned int _previous;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_THREAD_POOL_H__
+
@@ -0,0 +1,319 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <typeinfo>
+#include <utility>
+
+#include <boost/bind.hpp>
+
+#include <util/foreach.h>
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include <util/typename.h>
+#include "Logging.h"
+#include "ThreadPool.h"
+#include "UpdateScheduler.h"
+
+logger::LogChannel updateschedulerlog("updateschedulerlog", "[UpdateScheduler] ");
+
+namespace pipeline {
+
+util::ProgramOption optionScheduleUpdates(
+		util::_module           = "pipeline",
+		util::_long_name        = "scheduleUpdates",
+		util::_description_text = "Before a sink updates its inputs, find all dirty process nodes upstream of it and update "
+		                          "them in topological order, with independent process nodes running in parallel.");
+
+util::ProgramOption optionMaxBatchSize(
+		util::_module           = "pipeline",
+		util::_long_name        = "maxBatchSize",
+		util::_description_text = "The maximal number of batchable process nodes of the same type the UpdateScheduler "
+		                          "updates together. 1 disables batching.",
+		util::_default_value    = 64);
+
+util::ProgramOption optionAutoNumThreads(
+		util::_module           = "pipeline",
+		util::_long_name        = "autoNumThreads",
+		util::_description_text = "Let the UpdateScheduler adjust the number of active threads to the parallelism of the "
+		                          "dirty graph, i.e., the ratio of the total update time to the critical path. Update times "
+		                          "are measured if profiling is enabled. At most 'numThreads' threads are used.");
+
+namespace {
+
+struct TypeInfoLess {
+
+	bool operator()(const std::type_info* a, const std::type_info* b) const {
+
+		return a->before(*b);
+	}
+};
+
+} // anonymous namespace
+
+bool
+UpdateScheduler::isEnabled() {
+
+	static bool enabled = optionScheduleUpdates;
+
+	return enabled;
+}
+
+UpdateScheduler::UpdateScheduler(ProcessNode& sink) {
+
+	foreach (boost::shared_ptr<ProcessNode> upstream, sink.getUpstreamProcessNodes())
+		collect(upstream);
+
+	_numPending.reset(new boost::atomic<unsigned int>[_nodes.size()]);
+
+	for (unsigned int i = 0; i < _nodes.size(); i++)
+		_numPending[i] = _nodes[i].numUpstream;
+
+	analyze();
+
+	PIPELINE_LOG_ALL(updateschedulerlog)
+			<< "found " << _nodes.size() << " dirty process nodes, critical path "
+			<< _criticalPath << "ns, total work " << _totalWork << "ns" << std::endl;
+}
+
+void
+UpdateScheduler::run() {
+
+	if (_nodes.empty())
+		return;
+
+	static bool autoNumThreads = optionAutoNumThreads;
+
+	// the pool is shared with other users, limit it only for this update
+	ScopedActiveWorkers activeWorkers(autoNumThreads ? getTunedNumWorkers() : ThreadPool::getInstance().getNumActiveWorkers());
+
+	TaskGroup group;
+
+	std::vector<unsigned int> ready;
+	for (unsigned int i = 0; i < _nodes.size(); i++)
+		if (_nodes[i].numUpstream == 0)
+			ready.push_back(i);
+
+	dispatch(makeTasks(ready), 0, group);
+
+	group.wait();
+}
+
+double
+UpdateScheduler::getParallelism() const {
+
+	if (_criticalPath == 0)
+		return 1.0;
+
+	return static_cast<double>(_totalWork)/_criticalPath;
+}
+
+void
+UpdateScheduler::analyze() {
+
+	_criticalPath = 0;
+	_totalWork    = 0;
+
+	// the nodes are in topological order, downstream nodes come later
+	for (int i = _nodes.size() - 1; i >= 0; i--) {
+
+		Node& node = _nodes[i];
+
+		node.cost = std::max(node.processNode->getEstimatedCost(), static_cast<boost::uint64_t>(1));
+
+		boost::uint64_t downstream = 0;
+		foreach (unsigned int d, node.downstream)
+			downstream = std::max(downstream, _nodes[d].priority);
+
+		node.priority = node.cost + downstream;
+
+		_criticalPath  = std::max(_criticalPath, node.priority);
+		_totalWork    += node.cost;
+	}
+}
+
+unsigned int
+UpdateScheduler::getTunedNumWorkers() const {
+
+	// the thread running the scheduler takes part in the update
+	unsigned int numThreads = static_cast<unsigned int>(std::ceil(getParallelism()));
+
+	PIPELINE_LOG_ALL(updateschedulerlog) << "parallelism of the dirty graph is " << getParallelism() << std::endl;
+
+	return (numThreads > 1 ? numThreads - 1 : 1);
+}
+
+int
+UpdateScheduler::collect(boost::shared_ptr<ProcessNode> processNode) {
+
+	std::map<ProcessNode*, int>::iterator visited = _visited.find(processNode.get());
+
+	if (visited != _visited.end()) {
+
+		if (visited->second == -2)
+			LOG_ERROR(updateschedulerlog)
+					<< "cycle detected at " << typeName(*processNode)
+					<< ", ignoring the dependency" << std::endl;
+
+		return (visited->second < 0 ? -1 : visited->second);
+	}
+
+	// up-to-date process nodes end the search
+	if (!processNode->needsUpdate()) {
+
+		_visited[processNode.get()] = -1;
+		return -1;
+	}
+
+	_visited[processNode.get()] = -2;
+
+	std::vector<int> upstream;
+	foreach (boost::shared_ptr<ProcessNode> upstreamNode, processNode->getUpstreamProcessNodes()) {
+
+		int u = collect(upstreamNode);
+
+		if (u >= 0)
+			upstream.push_back(u);
+	}
+
+	// all upstream nodes are numbered already, thus the numbers are a
+	// topological order
+	int i = _nodes.size();
+
+	_nodes.push_back(Node());
+	_nodes[i].processNode = processNode;
+	_nodes[i].numUpstream = upstream.size();
+
+	foreach (int u, upstream)
+		_nodes[u].downstream.push_back(i);
+
+	_visited[processNode.get()] = i;
+
+	return i;
+}
+
+std::vector<std::vector<unsigned int> >
+UpdateScheduler::makeTasks(const std::vector<unsigned int>& ready) {
+
+	static unsigned int maxBatchSize = std::max(static_cast<int>(optionMaxBatchSize), 1);
+
+	typedef std::map<const std::type_info*, std::vector<unsigned int>, TypeInfoLess> Batches;
+
+	std::vector<std::vector<unsigned int> > tasks;
+	Batches                                 batches;
+
+	foreach (unsigned int i, ready) {
+
+		ProcessNode& processNode = *_nodes[i].processNode;
+
+		if (maxBatchSize > 1 && processNode.isBatchable())
+			batches[&typeid(processNode)].push_back(i);
+		else
+			tasks.push_back(std::vector<unsigned int>(1, i));
+	}
+
+	// one batch per worker, such that batching does not take parallelism 
+	// away
+	unsigned int numTasks = ThreadPool::getInstance().getNumActiveWorkers() + 1;
+
+	for (Batches::iterator b = batches.begin(); b != batches.end(); b++) {
+
+		std::vector<unsigned int>& nodes = b->second;
+
+		// the most critical instances end up in the first batch
+		std::vector<std::pair<boost::uint64_t, unsigned int> > byPriority;
+		foreach (unsigned int i, nodes)
+			byPriority.push_back(std::make_pair(_nodes[i].priority, i));
+		std::sort(byPriority.begin(), byPriority.end(), std::greater<std::pair<boost::uint64_t, unsigned int> >());
+
+		for (unsigned int k = 0; k < nodes.size(); k++)
+			nodes[k] = byPriority[k].second;
+
+		unsigned int batchSize = std::min((nodes.size() + numTasks - 1)/numTasks, static_cast<std::size_t>(maxBatchSize));
+
+		for (unsigned int begin = 0; begin < nodes.size(); begin += batchSize) {
+
+			unsigned int end = std::min(begin + batchSize, static_cast<unsigned int>(nodes.size()));
+
+			tasks.push_back(std::vector<unsigned int>(nodes.begin() + begin, nodes.begin() + end));
+		}
+	}
+
+	// most critical tasks first
+	std::vector<std::pair<boost::uint64_t, unsigned int> > order;
+	for (unsigned int t = 0; t < tasks.size(); t++)
+		order.push_back(std::make_pair(getPriority(tasks[t]), t));
+	std::sort(order.begin(), order.end(), std::greater<std::pair<boost::uint64_t, unsigned int> >());
+
+	std::vector<std::vector<unsigned int> > sorted(tasks.size());
+	for (unsigned int t = 0; t < order.size(); t++)
+		sorted[t].swap(tasks[order[t].second]);
+
+	return sorted;
+}
+
+void
+UpdateScheduler::dispatch(const std::vector<std::vector<unsigned int> >& tasks, unsigned int first, TaskGroup& group) {
+
+	// Tasks are stolen from the front of the queues, thus the most critical 
+	// ones are picked up first by idle workers. Note that a higher priority 
+	// does not preempt tasks that are already running.
+	for (unsigned int t = first; t < tasks.size(); t++)
+		group.run(boost::bind(&UpdateScheduler::process, this, tasks[t], boost::ref(group)));
+}
+
+void
+UpdateScheduler::process(std::vector<unsigned int> nodes, TaskGroup& group) {
+
+	while (true) {
+
+		ProcessNode& first = *_nodes[nodes[0]].processNode;
+
+		if (nodes.size() == 1) {
+
+			PIPELINE_LOG_ALL(updateschedulerlog) << "updating " << typeName(first) << std::endl;
+
+			first.updateScheduled();
+
+		} else {
+
+			PIPELINE_LOG_ALL(updateschedulerlog) << "updating a batch of " << nodes.size() << " " << typeName(first) << std::endl;
+
+			std::vector<ProcessNode*> processNodes;
+			foreach (unsigned int i, nodes)
+				processNodes.push_back(_nodes[i].processNode.get());
+
+			first.updateScheduledBatch(processNodes);
+		}
+
+		// release all downstream nodes that are ready now
+		std::vector<unsigned int> ready;
+		foreach (unsigned int i, nodes)
+			foreach (unsigned int d, _nodes[i].downstream)
+				if (--_numPending[d] == 0)
+					ready.push_back(d);
+
+		if (ready.empty())
+			return;
+
+		std::vector<std::vector<unsigned int> > tasks = makeTasks(ready);
+
+		// continue with the most critical task on this thread, without going 
+		// through the queues
+		dispatch(tasks, 1, group);
+
+		nodes.swap(tasks[0]);
+	}
+}
+
+boost::uint64_t
+UpdateScheduler::getPriority(const std::vector<unsigned int>& task) const {
+
+	boost::uint64_t priority = 0;
+
+	foreach (unsigned int i, task)
+		priority = std::max(priority, _nodes[i].priority);
+
+	return priority;
+}
+
+} // namespace pipeline
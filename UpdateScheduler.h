@@ -0,0 +1,154 @@
+#ifndef PIPELINE_UPDATE_SCHEDULER_H__
+#define PIPELINE_UPDATE_SCHEDULER_H__
+
+#include <map>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "ProcessNode.h"
+
+namespace pipeline {
+
+// forward declaration
+class TaskGroup;
+
+/**
+ * Graph-level update of all dirty process nodes upstream of a sink. The
+ * scheduler walks the inputs of the sink and collects all process nodes that
+ * need an update. Each of them is updated on the thread pool as soon as all
+ * its dirty upstream process nodes are done, such that independent branches
+ * of the graph are updated in parallel.
+ *
+ * The scheduler updates whole process nodes, i.e., all outputs of a dirty
+ * process node are recomputed, even if the sink depends only on some of them.
+ *
+ * Usage example:
+ *
+ *   UpdateScheduler scheduler(sink);
+ *   scheduler.run();
+ *
+ * After the scheduler finished, the regular Update signals sent by the sink
+ * will find all upstream process nodes up-to-date.
+ *
+ * Process nodes that are ready at the same time, batchable (see 
+ * SimpleProcessNode::setBatchable()), and of the same type are updated 
+ * together in batches of at most 'maxBatchSize' process nodes. Large batches 
+ * are split such that all workers of the thread pool get one.
+ *
+ * Before the update, the scheduler computes the critical path of the dirty 
+ * graph from the estimated costs of the process nodes (see 
+ * ProcessNode::getEstimatedCost(), which are measured if profiling is 
+ * enabled). Process nodes with unknown costs count as one nanosecond, such 
+ * that the critical path is the longest chain of process nodes. Of all ready 
+ * process nodes, the ones with the longest path to the sink are started 
+ * first, and the thread that finished a process node continues with the most 
+ * critical of the released ones. If the program option 'autoNumThreads' is 
+ * set, the number of active workers of the thread pool is adjusted to the 
+ * available parallelism of the graph for the duration of the update.
+ */
+class UpdateScheduler {
+
+public:
+
+	/**
+	 * Returns true, if the program option 'scheduleUpdates' was set.
+	 */
+	static bool isEnabled();
+
+	/**
+	 * Create a scheduler for all process nodes upstream of the given sink.
+	 */
+	UpdateScheduler(ProcessNode& sink);
+
+	/**
+	 * Update all dirty upstream process nodes and wait for them to finish.
+	 */
+	void run();
+
+	/**
+	 * Get the number of process nodes that have been found dirty.
+	 */
+	unsigned int size() const { return _nodes.size(); }
+
+	/**
+	 * Get the estimated time in nanoseconds of the longest chain of dependent 
+	 * updates.
+	 */
+	boost::uint64_t getCriticalPath() const { return _criticalPath; }
+
+	/**
+	 * Get the estimated time in nanoseconds of all updates.
+	 */
+	boost::uint64_t getTotalWork() const { return _totalWork; }
+
+	/**
+	 * Get the available parallelism of the dirty graph, i.e., the ratio of the 
+	 * total work to the critical path.
+	 */
+	double getParallelism() const;
+
+private:
+
+	struct Node {
+
+		boost::shared_ptr<ProcessNode> processNode;
+
+		// the numbers of dirty process nodes that depend on this one
+		std::vector<unsigned int> downstream;
+
+		// the number of dirty process nodes this one depends on
+		unsigned int numUpstream;
+
+		// the estimated cost of updating this node
+		boost::uint64_t cost;
+
+		// the cost of the longest path from this node to the sink, including 
+		// this node
+		boost::uint64_t priority;
+	};
+
+	// compute the priorities, the critical path, and the total work
+	void analyze();
+
+	// get the number of active workers that matches the parallelism
+	unsigned int getTunedNumWorkers() const;
+
+	// add a process node and all of its dirty upstream nodes, returns -1 if
+	// the process node is up-to-date
+	int collect(boost::shared_ptr<ProcessNode> processNode);
+
+	// group the given ready nodes into tasks, batchable nodes of the same 
+	// type are combined into one task, the most critical task comes first
+	std::vector<std::vector<unsigned int> > makeTasks(const std::vector<unsigned int>& ready);
+
+	// start the given tasks, from the first one
+	void dispatch(const std::vector<std::vector<unsigned int> >& tasks, unsigned int first, TaskGroup& group);
+
+	// update the given nodes and the most critical downstream nodes that 
+	// became ready, dispatch the others
+	void process(std::vector<unsigned int> nodes, TaskGroup& group);
+
+	// the priority of a task
+	boost::uint64_t getPriority(const std::vector<unsigned int>& task) const;
+
+	std::vector<Node> _nodes;
+
+	// process nodes visited so far and their numbers (-1 for up-to-date
+	// nodes, -2 for nodes currently visited)
+	std::map<ProcessNode*, int> _visited;
+
+	// the number of unfinished upstream nodes for each node
+	boost::scoped_array<boost::atomic<unsigned int> > _numPending;
+
+	boost::uint64_t _criticalPath;
+	boost::uint64_t _totalWork;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_UPDATE_SCHEDULER_H__
+
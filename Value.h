@@ -15,6 +15,9 @@ namespace pipeline {
  *   Value<Image> image = imageReader->getOutput();
  *
  *   int width = image->getWidth();
+ *
+ * Each value owns a process node to receive the data. For a large number of 
+ * small values (like parameters), see InlineValue.
  */
 template <typename T>
 class ValueImpl {
@@ -37,8 +40,27 @@ private:
 			return _data.getSharedPointer();
 		}
 
+		/**
+		 * Update asynchronously and fulfill the promise with the converted 
+		 * data.
+		 */
+		template <typename R>
+		void getAsync(boost::shared_ptr<boost::promise<R> > promise, R (*convert)(boost::shared_ptr<T>)) {
+
+			updateInputsAsync(boost::bind(&UpdateValue::template fulfill<R>, this, promise, convert, _1));
+		}
+
 	private:
 
+		template <typename R>
+		void fulfill(boost::shared_ptr<boost::promise<R> > promise, R (*convert)(boost::shared_ptr<T>), const boost::exception_ptr& exception) {
+
+			if (exception)
+				promise->set_exception(exception);
+			else
+				promise->set_value(convert(_data.getSharedPointer()));
+		}
+
 		void updateOutputs() {}
 
 		pipeline::Input<T> _data;
@@ -79,6 +101,18 @@ public:
 		return getSharedPointer();
 	}
 
+	/**
+	 * Non-blocking access to the stored data. The update of the value is 
+	 * performed on the thread pool, concurrent requests are merged into one 
+	 * update (see SimpleProcessNode::updateInputsAsync()).
+	 *
+	 * @return A future of a boost::shared_ptr to the stored data.
+	 */
+	boost::shared_future<boost::shared_ptr<T> > getAsync() {
+
+		return getAsync(&identity);
+	}
+
 protected:
 
 	Process<UpdateValue>& getUpdateProcessNode() { return _updateValue; }
@@ -102,8 +136,25 @@ protected:
 		return _updateValue->get();
 	}
 
+	/**
+	 * Get a future of the data stored by this pipeline value, converted by the 
+	 * given function.
+	 */
+	template <typename R>
+	boost::shared_future<R> getAsync(R (*convert)(boost::shared_ptr<T>)) {
+
+		boost::shared_ptr<boost::promise<R> > promise = boost::make_shared<boost::promise<R> >();
+		boost::shared_future<R> future = promise->get_future().share();
+
+		_updateValue->getAsync(promise, convert);
+
+		return future;
+	}
+
 private:
 
+	static boost::shared_ptr<T> identity(boost::shared_ptr<T> data) { return data; }
+
 	Process<UpdateValue> _updateValue;
 };
 
@@ -138,6 +189,16 @@ public:
 
 		parent_type::set(boost::make_shared<Wrap<T> >(p));
 	}
+
+	// transparent unwrapper for asynchronous access
+	boost::shared_future<boost::shared_ptr<T> > getAsync() {
+
+		return parent_type::getAsync(&unwrap);
+	}
+
+private:
+
+	static boost::shared_ptr<T> unwrap(boost::shared_ptr<Wrap<T> > wrap) { return wrap->getSharedPointer(); }
 };
 
 template <typename T>
@@ -20,12 +20,12 @@ public:
 	Wrap(boost::shared_ptr<T> value) :
 		_value(value) {}
 
-	T* get() {
+	T* get() const {
 
 		return _value.get();
 	}
 
-	boost::shared_ptr<T> getSharedPointer() {
+	boost::shared_ptr<T> getSharedPointer() const {
 
 		return _value;
 	}
@@ -0,0 +1,376 @@
+/**
+ * Microbenchmarks for signal propagation and updates in different graph
+ * topologies, for each of the locking strategies of SimpleProcessNode. All
+ * outputs enable double buffering, which is used by the 
+ * DoubleBufferedLockingStrategy only.
+ *
+ * For each graph, the sources are modified and the sink pulls the result,
+ * repeatedly. The benchmark reports the average time to propagate the
+ * Modified signals, the average time of the sink's updateInputs(), and the
+ * resulting number of updates per second.
+ *
+ * Each measurement is repeated for 1, 2, 4, ... active workers of the thread
+ * pool, up to the number of workers given by the program option 'numThreads'.
+ *
+ * The benchmark is built only if the CMake option BUILD_PIPELINE_BENCHMARK is
+ * enabled.
+ */
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/exception/diagnostic_information.hpp>
+#include <boost/make_shared.hpp>
+
+#include <util/foreach.h>
+#include <util/Logger.h>
+#include <util/ProgramOptions.h>
+#include <pipeline/FlatInputs.h>
+#include <pipeline/Profiling.h>
+#include <pipeline/SimpleProcessNode.h>
+#include <pipeline/ThreadPool.h>
+
+util::ProgramOption optionBenchmarkIterations(
+		util::_module           = "benchmark",
+		util::_long_name        = "iterations",
+		util::_description_text = "The number of modify/update iterations per graph.",
+		util::_default_value    = 100);
+
+util::ProgramOption optionBenchmarkWork(
+		util::_module           = "benchmark",
+		util::_long_name        = "work",
+		util::_description_text = "The amount of work done by each branch of the diamond graph per update.",
+		util::_default_value    = 10000);
+
+struct Number : pipeline::Data {
+
+	Number() : value(0) {}
+
+	double value;
+};
+
+template <typename LockingStrategy>
+class Source : public pipeline::SimpleProcessNode<LockingStrategy> {
+
+public:
+
+	Source() {
+
+		this->registerOutput(_output, "output");
+
+		_output = new Number();
+		_output.enableDoubleBuffering(true);
+	}
+
+	void modify() {
+
+		this->setDirty(_output);
+	}
+
+private:
+
+	void updateOutputs() {
+
+		_output->value += 1;
+	}
+
+	pipeline::Output<Number> _output;
+};
+
+template <typename LockingStrategy>
+class Pass : public pipeline::SimpleProcessNode<LockingStrategy> {
+
+public:
+
+	Pass(int work = 0) :
+		_work(work) {
+
+		this->registerInput(_input, "input");
+		this->registerOutput(_output, "output");
+
+		_output = new Number();
+		_output.enableDoubleBuffering();
+	}
+
+private:
+
+	void updateOutputs() {
+
+		double value = _input->value;
+
+		for (int i = 0; i < _work; i++)
+			value = std::sqrt(value + i);
+
+		_output->value = value;
+	}
+
+	int _work;
+
+	pipeline::Input<Number>  _input;
+	pipeline::Output<Number> _output;
+};
+
+template <typename LockingStrategy, template <typename> class MultiInputType = pipeline::Inputs>
+class Sum : public pipeline::SimpleProcessNode<LockingStrategy> {
+
+public:
+
+	Sum() {
+
+		this->registerInputs(_inputs, "inputs");
+		this->registerOutput(_output, "output");
+
+		_output = new Number();
+		_output.enableDoubleBuffering();
+	}
+
+private:
+
+	void updateOutputs() {
+
+		double sum = 0;
+
+		typedef typename MultiInputType<Number>::const_iterator const_iterator;
+
+		for (const_iterator i = _inputs.begin(); i != _inputs.end(); i++)
+			sum += (*i)->value;
+
+		_output->value = sum;
+	}
+
+	MultiInputType<Number> _inputs;
+	pipeline::Output<Number> _output;
+};
+
+template <typename LockingStrategy>
+class Sink : public pipeline::SimpleProcessNode<LockingStrategy> {
+
+public:
+
+	Sink() {
+
+		this->registerInput(_input, "input");
+	}
+
+	double pull() {
+
+		this->updateInputs();
+
+		return _input->value;
+	}
+
+private:
+
+	void updateOutputs() {}
+
+	pipeline::Input<Number> _input;
+};
+
+template <typename LockingStrategy>
+struct Graph {
+
+	void modify() {
+
+		foreach (boost::shared_ptr<Source<LockingStrategy> > source, sources)
+			source->modify();
+	}
+
+	std::vector<boost::shared_ptr<Source<LockingStrategy> > > sources;
+
+	// all other nodes, to keep them alive
+	std::vector<boost::shared_ptr<pipeline::ProcessNode> > nodes;
+
+	boost::shared_ptr<Sink<LockingStrategy> > sink;
+};
+
+/**
+ * source -> pass -> ... -> pass -> sink
+ */
+template <typename LockingStrategy>
+void makeChain(Graph<LockingStrategy>& graph, unsigned int length) {
+
+	graph.sources.push_back(boost::make_shared<Source<LockingStrategy> >());
+
+	pipeline::OutputBase* last = &graph.sources[0]->getOutput();
+
+	for (unsigned int i = 0; i < length; i++) {
+
+		boost::shared_ptr<Pass<LockingStrategy> > pass = boost::make_shared<Pass<LockingStrategy> >();
+		pass->setInput(*last);
+
+		graph.nodes.push_back(pass);
+		last = &pass->getOutput();
+	}
+
+	graph.sink = boost::make_shared<Sink<LockingStrategy> >();
+	graph.sink->setInput(*last);
+}
+
+/**
+ * source -> (width parallel passes) -> sum -> sink
+ */
+template <typename LockingStrategy>
+void makeDiamond(Graph<LockingStrategy>& graph, unsigned int width, int work) {
+
+	graph.sources.push_back(boost::make_shared<Source<LockingStrategy> >());
+
+	boost::shared_ptr<Sum<LockingStrategy> > sum = boost::make_shared<Sum<LockingStrategy> >();
+	graph.nodes.push_back(sum);
+
+	for (unsigned int i = 0; i < width; i++) {
+
+		boost::shared_ptr<Pass<LockingStrategy> > pass = boost::make_shared<Pass<LockingStrategy> >(work);
+		pass->setInput(graph.sources[0]->getOutput());
+		sum->addInput(pass->getOutput());
+
+		graph.nodes.push_back(pass);
+	}
+
+	graph.sink = boost::make_shared<Sink<LockingStrategy> >();
+	graph.sink->setInput(sum->getOutput());
+}
+
+/**
+ * (size sources) -> sum -> sink
+ */
+template <template <typename> class MultiInputType, typename LockingStrategy>
+void makeFanIn(Graph<LockingStrategy>& graph, unsigned int size) {
+
+	boost::shared_ptr<Sum<LockingStrategy, MultiInputType> > sum = boost::make_shared<Sum<LockingStrategy, MultiInputType> >();
+	graph.nodes.push_back(sum);
+
+	for (unsigned int i = 0; i < size; i++) {
+
+		graph.sources.push_back(boost::make_shared<Source<LockingStrategy> >());
+		sum->addInput(graph.sources.back()->getOutput());
+	}
+
+	graph.sink = boost::make_shared<Sink<LockingStrategy> >();
+	graph.sink->setInput(sum->getOutput());
+}
+
+template <typename LockingStrategy>
+void measure(const std::string& strategy, const std::string& graphName, Graph<LockingStrategy>& graph) {
+
+	int iterations = optionBenchmarkIterations;
+
+	// initial update of the whole graph
+	graph.sink->pull();
+
+	pipeline::Profiler::time_type modifiedTime = 0;
+	pipeline::Profiler::time_type updateTime   = 0;
+
+	for (int i = 0; i < iterations; i++) {
+
+		pipeline::Profiler::time_type start = pipeline::Profiler::now();
+
+		graph.modify();
+
+		pipeline::Profiler::time_type modified = pipeline::Profiler::now();
+
+		graph.sink->pull();
+
+		pipeline::Profiler::time_type updated = pipeline::Profiler::now();
+
+		modifiedTime += modified - start;
+		updateTime   += updated - modified;
+	}
+
+	double modifiedUs = modifiedTime*1e-3/iterations;
+	double updateUs   = updateTime*1e-3/iterations;
+
+	std::cout
+			<< std::setw(12) << std::left << strategy
+			<< std::setw(16) << graphName
+			<< std::setw(10) << std::right << pipeline::ThreadPool::getInstance().getNumActiveWorkers()
+			<< std::setw(16) << std::fixed << std::setprecision(2) << modifiedUs
+			<< std::setw(16) << updateUs
+			<< std::setw(16) << std::setprecision(1) << 1e6/(modifiedUs + updateUs)
+			<< std::endl;
+}
+
+template <typename LockingStrategy>
+void benchmarkStrategy(const std::string& strategy) {
+
+	int work = optionBenchmarkWork;
+
+	{
+		Graph<LockingStrategy> graph;
+		makeChain(graph, 10);
+		measure(strategy, "chain(10)", graph);
+	}
+
+	{
+		Graph<LockingStrategy> graph;
+		makeDiamond(graph, 16, work);
+		measure(strategy, "diamond(16)", graph);
+	}
+
+	{
+		Graph<LockingStrategy> graph;
+		makeFanIn<pipeline::Inputs>(graph, 10000);
+		measure(strategy, "fan-in(10000)", graph);
+	}
+
+	{
+		Graph<LockingStrategy> graph;
+		makeFanIn<pipeline::FlatInputs>(graph, 10000);
+		measure(strategy, "flat-in(10000)", graph);
+	}
+
+	{
+		Graph<LockingStrategy> graph;
+		makeChain(graph, 1000);
+		measure(strategy, "deep(1000)", graph);
+	}
+}
+
+int main(int argc, char** argv) {
+
+	try {
+
+		util::ProgramOptions::init(argc, argv);
+		logger::LogManager::init();
+
+		std::cout
+				<< std::setw(12) << std::left << "strategy"
+				<< std::setw(16) << "graph"
+				<< std::setw(10) << std::right << "threads"
+				<< std::setw(16) << "modified [us]"
+				<< std::setw(16) << "update [us]"
+				<< std::setw(16) << "updates/s"
+				<< std::endl;
+
+		pipeline::ThreadPool& pool = pipeline::ThreadPool::getInstance();
+
+		// sweep over the number of active workers, in powers of two up to 
+		// the size of the pool given by the option 'numThreads'
+		std::vector<unsigned int> numThreads;
+		for (unsigned int n = 1; n < pool.getNumWorkers(); n *= 2)
+			numThreads.push_back(n);
+		numThreads.push_back(pool.getNumWorkers());
+
+		foreach (unsigned int n, numThreads) {
+
+			// the pool is shared by the whole process, limit it only for 
+			// this measurement
+			pipeline::ScopedActiveWorkers activeWorkers(n, pool);
+
+			benchmarkStrategy<pipeline::FullLockingStrategy>("full");
+			benchmarkStrategy<pipeline::InputLockingStrategy>("input");
+			benchmarkStrategy<pipeline::OutputLockingStrategy>("output");
+			benchmarkStrategy<pipeline::NoLockingStrategy>("none");
+			benchmarkStrategy<pipeline::DoubleBufferedLockingStrategy>("double");
+		}
+
+	} catch (boost::exception& e) {
+
+		std::cerr << boost::diagnostic_information(e) << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,17 @@
+#ifndef PIPELINE_SIGNALS_CHUNK_AVAILABLE_H__
+#define PIPELINE_SIGNALS_CHUNK_AVAILABLE_H__
+
+#include "PipelineSignal.h"
+
+namespace pipeline {
+
+/**
+ * Forward signal. Indicates that a new chunk was pushed into the stream of a 
+ * stream output.
+ */
+class ChunkAvailable : public PipelineSignal { public: ChunkAvailable() {} };
+
+} // namespace pipeline
+
+#endif // PIPELINE_SIGNALS_CHUNK_AVAILABLE_H__
+
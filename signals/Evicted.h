@@ -0,0 +1,24 @@
+#ifndef PIPELINE_SIGNALS_EVICTED_H__
+#define PIPELINE_SIGNALS_EVICTED_H__
+
+#include "Modified.h"
+
+namespace pipeline {
+
+/**
+ * Forward signal. Indicates that the data of an output has been released to 
+ * save memory. The content did not change, but the output has to be updated 
+ * before it can be read again. Receivers that are not aware of eviction treat 
+ * it as Modified.
+ */
+class Evicted : public Modified {
+
+public:
+
+	Evicted() : Modified(true) {}
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_SIGNALS_EVICTED_H__
+
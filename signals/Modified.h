@@ -8,7 +8,27 @@ namespace pipeline {
 /**
  * Forward signal. Indicates that an output object has been modified.
  */
-class Modified : public PipelineSignal { public: Modified() {} };
+class Modified : public PipelineSignal {
+
+public:
+
+	Modified() : _evicted(false) {}
+
+	/**
+	 * True, if this signal is an Evicted signal, i.e., if the content of the 
+	 * output did not change but it has to be updated before it can be read 
+	 * again.
+	 */
+	bool isEvicted() const { return _evicted; }
+
+protected:
+
+	Modified(bool evicted) : _evicted(evicted) {}
+
+private:
+
+	bool _evicted;
+};
 
 } // namespace pipeline
 
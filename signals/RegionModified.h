@@ -0,0 +1,30 @@
+#ifndef PIPELINE_SIGNALS_REGION_MODIFIED_H__
+#define PIPELINE_SIGNALS_REGION_MODIFIED_H__
+
+#include <pipeline/Region.h>
+#include "Modified.h"
+
+namespace pipeline {
+
+/**
+ * Forward signal. Indicates that a region of an output object has been 
+ * modified. Receivers that are not aware of regions treat it as Modified.
+ */
+class RegionModified : public Modified {
+
+public:
+
+	RegionModified(const Region& region = Region::everything()) :
+		_region(region) {}
+
+	const Region& getRegion() const { return _region; }
+
+private:
+
+	Region _region;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_SIGNALS_REGION_MODIFIED_H__
+
@@ -0,0 +1,30 @@
+#ifndef PIPELINE_SIGNALS_REGION_UPDATE_H__
+#define PIPELINE_SIGNALS_REGION_UPDATE_H__
+
+#include <pipeline/Region.h>
+#include "Update.h"
+
+namespace pipeline {
+
+/**
+ * Backward signal. Requests the update of a region of input objects. 
+ * Receivers that are not aware of regions treat it as Update.
+ */
+class RegionUpdate : public Update {
+
+public:
+
+	RegionUpdate(const Region& region = Region::everything()) :
+		_region(region) {}
+
+	const Region& getRegion() const { return _region; }
+
+private:
+
+	Region _region;
+};
+
+} // namespace pipeline
+
+#endif // PIPELINE_SIGNALS_REGION_UPDATE_H__
+
@@ -1,7 +1,11 @@
 #ifndef PIPELINE_SIGNALS_ALL_H__
 #define PIPELINE_SIGNALS_ALL_H__
 
+#include "ChunkAvailable.h"
+#include "Evicted.h"
 #include "Modified.h"
+#include "RegionModified.h"
+#include "RegionUpdate.h"
 #include "Update.h"
 
 #endif // PIPELINE_SIGNALS_ALL_H__